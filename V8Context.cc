@@ -1,4 +1,7 @@
 #include <unistd.h>
+#if defined(PL_HAVE_ICU_UDATA)
+#include <unicode/udata.h>
+#endif
 #include <v8-version.h>
 #include <libplatform/libplatform.h>
 #include "pl_util.h"
@@ -9,6 +12,17 @@
 #include "pl_eventloop.h"
 #include "pl_inlined.h"
 #include "pl_stats.h"
+#include "pl_bind.h"
+#include "pl_sync.h"
+#include "pl_persist.h"
+#include "pl_snapshot.h"
+#include "pl_sandbox.h"
+#include "pl_watchdog.h"
+#include "pl_recycle.h"
+#include "pl_heap.h"
+#include "pl_metrics.h"
+#include "pl_monitor.h"
+#include "pl_profiler.h"
 #include "V8Context.h"
 #include "ppport.h"
 
@@ -19,36 +33,91 @@
 #define V8_NATIVES_BLOB      "natives_blob.bin"
 #define V8_SNAPSHOT_BLOB     "snapshot_blob.bin"
 
-#define MAX_MEMORY_MINIMUM  (128 * 1024) /* 128 KB */
+#define V8_PREFORK_FLAGS     "--single-threaded"
+#define V8_PREFORK_POOL_SIZE 1
+
+#define MAX_MEMORY_MINIMUM  (16 * 1024 * 1024) /* 16 MB, V8 cannot do much with less */
 #define MAX_TIMEOUT_MINIMUM (500000)     /* 500_000 us = 500 ms = 0.5 s */
 
 #define ENTER_SCOPE \
+    if (!isolate->IsInUse()) enter(); \
     Isolate::Scope isolate_scope(isolate); \
     HandleScope handle_scope(isolate)
 
 int V8Context::instance_count = 0;
+int V8Context::prefork_mode = 0;
+int V8Context::thread_pool_size = 0;
+int V8Context::idle_tasks = 0;
+int V8Context::profile = -1;
+
+/*
+ * Runtime profiles: a set of V8 flags (applied when configuring) and of heap
+ * constraints (applied to every isolate created afterwards).  Zero means the
+ * V8 default for a constraint.
+ *
+ * low_memory: prefer small code and heaps; do GC work in the main thread.
+ * throughput: large young generation, so there are fewer scavenges.
+ * latency: small young generation, so each scavenge pause is short.
+ */
+static struct Profile {
+    const char* name;
+    const char* flags;
+    size_t max_semi_space_kb;
+    size_t max_old_space_mb;
+} profiles[] = {
+    { "low_memory", "--optimize-for-size --single-threaded-gc", 1024, 128 },
+    { "throughput", "--no-memory-reducer", 16384, 0 },
+    { "latency"   , "--no-memory-reducer", 2048, 0 },
+};
+long V8Context::fork_parent_pid = 0;
 std::unique_ptr<v8::Platform> V8Context::platform = 0;
 
 V8Context::V8Context(HV* opt)
     : isolate(0),
       persistent_context(0),
       persistent_template(0),
+      bind_hash_template(0),
+      bind_array_template(0),
       flags(0),
       version(0),
       stats(0),
+      stats_table(0),
       msgs(0),
+      classes(0),
+      sync_generation(0),
       pagesize_bytes(0),
       max_allocated_bytes(0),
+      initial_heap_limit(0),
+      terminate_reason(0),
+      heap_used_before_gc(0),
+      gc_started_us(0),
+      heap_freed_bytes(0),
       max_timeout_us(0),
+      watchdog_depth(0),
+      watchdog_armed(false),
+      watchdog_deadline(0),
+      max_convert_nodes(0),
+      max_convert_bytes(0),
+      recycle_after_evals(0),
+      recycle_after_seconds(0),
+      recycle_above_heap_bytes(0),
+      recycle_evals(0),
+      recycle_started_us(0),
+      recycle_reason(0),
+      pending_error(0),
       inited(0)
 {
     V8Context::initialize_v8();
 
+    snapshot_blob.data = 0;
+    snapshot_blob.raw_size = 0;
     pagesize_bytes = total_memory_pages();
     stats = newHV();
     msgs = newHV();
+    classes = newHV();
     flags = 0;
 
+    long sample_rate = 1;
     if (opt) {
         hv_iterinit(opt);
         while (1) {
@@ -85,19 +154,71 @@ V8Context::V8Context(HV* opt)
                 max_timeout_us = param > MAX_TIMEOUT_MINIMUM ? param : MAX_TIMEOUT_MINIMUM;
                 continue;
             }
+            if (memcmp(kstr, V8_OPT_NAME_MAX_CONVERT_NODES, klen) == 0) {
+                long param = SvIV(value);
+                max_convert_nodes = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_MAX_CONVERT_BYTES, klen) == 0) {
+                long param = SvIV(value);
+                max_convert_bytes = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_RECYCLE_AFTER_EVALS, klen) == 0) {
+                long param = SvIV(value);
+                recycle_after_evals = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_RECYCLE_AFTER_SECONDS, klen) == 0) {
+                double param = SvNV(value);
+                recycle_after_seconds = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_RECYCLE_ABOVE_HEAP_BYTES, klen) == 0) {
+                long param = SvIV(value);
+                recycle_above_heap_bytes = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_STATS_SAMPLE_RATE, klen) == 0) {
+                sample_rate = SvIV(value);
+                continue;
+            }
+            if (memcmp(kstr, V8_OPT_NAME_SNAPSHOT, klen) == 0) {
+                pl_snapshot_load(aTHX_ SvPV_nolen(value), &snapshot_blob);
+                continue;
+            }
             croak("Unknown option %*.*s\n", (int) klen, (int) klen, kstr);
         }
     }
+    pl_stats_init(this, sample_rate);
 
+    if (profile >= 0) {
+        if (profiles[profile].max_semi_space_kb) {
+            create_params.constraints.set_max_semi_space_size_in_kb(profiles[profile].max_semi_space_kb);
+        }
+        if (profiles[profile].max_old_space_mb) {
+            create_params.constraints.set_max_old_space_size(profiles[profile].max_old_space_mb);
+        }
+    }
     create_params.array_buffer_allocator =
-        ArrayBuffer::Allocator::NewDefaultAllocator();
+        pl_sandbox_create_allocator(this, create_params);
+    if (snapshot_blob.data) {
+        create_params.snapshot_blob = &snapshot_blob;
+        create_params.external_references = pl_snapshot_external_references();
+    }
     set_up();
 }
 
 V8Context::~V8Context()
 {
     tear_down();
+    pl_recycle_destroy(this);
+    pl_bind_destroy(aTHX_ this);
+    pl_persist_destroy(this);
     delete create_params.array_buffer_allocator;
+    pl_snapshot_free(&snapshot_blob);
+    pl_stats_free(this);
+    SvREFCNT_dec(pending_error);
 
 #if 0
     /*
@@ -110,118 +231,344 @@ V8Context::~V8Context()
 #endif
 }
 
-SV* V8Context::get(const char* name)
+SV* V8Context::get(const char* name, HV* opt)
 {
-    ENTER_SCOPE;
-    set_up();
+    ConvOpts opts;
+    pl_get_conv_opts(aTHX_ opt, &opts);
+
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_GET);
+        ret = pl_get_global_or_property(aTHX_ this, name, opt ? &opts : 0);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
+    return ret;
+}
 
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_get_global_or_property(aTHX_ this, name);
-    pl_stats_stop(aTHX_ this, &perf, "get");
+SV* V8Context::get_many(AV* names)
+{
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_GET_MANY);
+        ret = pl_get_globals_or_properties(aTHX_ this, names);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
     return ret;
 }
 
 SV* V8Context::exists(const char* name)
 {
-    ENTER_SCOPE;
-    set_up();
-
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_exists_global_or_property(aTHX_ this, name);
-    pl_stats_stop(aTHX_ this, &perf, "exists");
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_EXISTS);
+        ret = pl_exists_global_or_property(aTHX_ this, name);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
     return ret;
 }
 
 SV* V8Context::typeof(const char* name)
 {
-    ENTER_SCOPE;
-    set_up();
-
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_typeof_global_or_property(aTHX_ this, name);
-    pl_stats_stop(aTHX_ this, &perf, "typeof");
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_TYPEOF);
+        ret = pl_typeof_global_or_property(aTHX_ this, name);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
     return ret;
 }
 
 SV* V8Context::instanceof(const char* oname, const char* cname)
 {
-    ENTER_SCOPE;
-    set_up();
-
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_instanceof_global_or_property(aTHX_ this, oname, cname);
-    pl_stats_stop(aTHX_ this, &perf, "instanceof");
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_INSTANCEOF);
+        ret = pl_instanceof_global_or_property(aTHX_ this, oname, cname);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
     return ret;
 }
 
 void V8Context::set(const char* name, SV* value)
 {
-    ENTER_SCOPE;
-    set_up();
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_SET);
+        pl_set_global_or_property(aTHX_ this, name, value);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
 
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    pl_set_global_or_property(aTHX_ this, name, value);
-    pl_stats_stop(aTHX_ this, &perf, "set");
+void V8Context::set_many(HV* values)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_SET_MANY);
+        pl_set_globals_or_properties(aTHX_ this, values);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
 }
 
-void V8Context::remove(const char* name)
+void V8Context::set_persistent(const char* name, SV* value)
 {
-    ENTER_SCOPE;
-    set_up();
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_SET_PERSISTENT);
+        pl_persist_global_or_property(aTHX_ this, name, value);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
 
-    Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    pl_del_global_or_property(aTHX_ this, name);
-    pl_stats_stop(aTHX_ this, &perf, "remove");
+void V8Context::set_lazy(const char* name, SV* func)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_SET_LAZY);
+        pl_set_lazy_global_or_property(aTHX_ this, name, func);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
+
+void V8Context::sync(const char* name, SV* value)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_SYNC);
+        pl_sync_global_or_property(aTHX_ this, name, value);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
+
+void V8Context::bind(const char* name, SV* ref)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_BIND);
+        pl_bind_global_or_property(aTHX_ this, name, ref);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
+
+void V8Context::bind_scalar(const char* name, SV* ref)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_BIND_SCALAR);
+        pl_bind_scalar_global_or_property(aTHX_ this, name, ref);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
+
+void V8Context::register_class(const char* package, AV* methods)
+{
+    pl_bind_register_class(aTHX_ this, package, methods);
+}
+
+void V8Context::remove(const char* name)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_REMOVE);
+        pl_del_global_or_property(aTHX_ this, name);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
 }
 
 SV* V8Context::eval(const char* code, const char* file)
 {
-    ENTER_SCOPE;
-    set_up();
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        /* performance is tracked inside this call */
+        ret = pl_eval(aTHX_ this, code, file);
+        pl_recycle_check(this);
+    }
+    croak_on_failure(ret);
+    return ret;
+}
+
+void V8Context::eval_void(const char* code, const char* file)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
 
-    /* performance is tracked inside this call */
-    return pl_eval(aTHX_ this, code, file);
+        /* performance is tracked inside this call */
+        pl_eval(aTHX_ this, code, file, false);
+        pl_recycle_check(this);
+    }
+    croak_on_failure();
 }
 
 SV* V8Context::dispatch_function_in_event_loop(const char* func)
+{
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_DISPATCH);
+        ret = pl_run_function_in_event_loop(aTHX_ this, func);
+        pump_tasks();
+        pl_stats_stop(aTHX_ this, &perf);
+        pl_recycle_check(this);
+    }
+    croak_on_failure(ret);
+    return ret;
+}
+
+SV* V8Context::global_objects()
+{
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_GLOBAL_OBJECTS);
+        ret = pl_global_objects(aTHX_ this);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
+    return ret;
+}
+
+int V8Context::run_gc()
 {
     ENTER_SCOPE;
     set_up();
 
     Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_run_function_in_event_loop(aTHX_ this, func);
-    pl_stats_stop(aTHX_ this, &perf, "dispatch");
+    pl_stats_start(aTHX_ this, &perf, PL_STAT_RUN_GC);
+    int ret = pl_run_gc(this);
+    pl_stats_stop(aTHX_ this, &perf);
     return ret;
 }
 
-SV* V8Context::global_objects()
+int V8Context::idle_gc(double deadline_ms)
 {
     ENTER_SCOPE;
     set_up();
 
     Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    SV* ret = pl_global_objects(aTHX_ this);
-    pl_stats_stop(aTHX_ this, &perf, "global_objects");
+    pl_stats_start(aTHX_ this, &perf, PL_STAT_IDLE_GC);
+    double now = platform->MonotonicallyIncreasingTime();
+    double deadline = now + (deadline_ms > 0 ? deadline_ms : 0) / 1000.0;
+    int ret = pl_idle_gc(this, deadline);
+    if (idle_tasks) {
+        /* use whatever time is left to run the idle tasks posted by V8 */
+        double left = deadline - platform->MonotonicallyIncreasingTime();
+        if (left > 0) {
+            v8::platform::RunIdleTasks(platform.get(), isolate, left);
+        }
+    }
+    pl_stats_stop(aTHX_ this, &perf);
     return ret;
 }
 
-int V8Context::run_gc()
+void V8Context::memory_pressure(const char* level)
 {
+    int pressure = pl_memory_pressure_level(level);
+    if (pressure < 0) {
+        croak("Unknown memory pressure level %s\n", level);
+    }
+
     ENTER_SCOPE;
     set_up();
 
     Perf perf;
-    pl_stats_start(aTHX_ this, &perf);
-    int ret = pl_run_gc(this);
-    pl_stats_stop(aTHX_ this, &perf, "run_gc");
+    pl_stats_start(aTHX_ this, &perf, PL_STAT_MEMORY_PRESSURE);
+    pl_memory_pressure(this, pressure);
+    pl_stats_stop(aTHX_ this, &perf);
+}
+
+void V8Context::start_profiling(const char* name, HV* opt)
+{
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_START_PROFILING);
+        pl_profiler_start(aTHX_ this, name, opt);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure();
+}
+
+SV* V8Context::stop_profiling(const char* name)
+{
+    SV* ret = 0;
+    {
+        ENTER_SCOPE;
+        set_up();
+
+        Perf perf;
+        pl_stats_start(aTHX_ this, &perf, PL_STAT_STOP_PROFILING);
+        ret = pl_profiler_stop(aTHX_ this, name);
+        pl_stats_stop(aTHX_ this, &perf);
+    }
+    croak_on_failure(ret);
     return ret;
 }
 
@@ -235,12 +582,22 @@ HV* V8Context::get_version_info()
 
 HV* V8Context::get_stats()
 {
+    pl_stats_materialize(aTHX_ this);
     return stats;
 }
 
+SV* V8Context::get_heap_stats()
+{
+    ENTER_SCOPE;
+    set_up();
+
+    return pl_heap_get_stats(aTHX_ this);
+}
+
 void V8Context::reset_stats()
 {
     stats = newHV();
+    pl_stats_reset(this);
 }
 
 HV* V8Context::get_msgs()
@@ -264,8 +621,14 @@ void V8Context::set_up()
     double t0 = now_us();
 #endif
 
-    /* Create a new Isolate and make it the current one. */
-    isolate = Isolate::New(create_params);
+    /* Create a new Isolate (or use one created in the background). */
+    isolate = pl_recycle_take_isolate(this);
+    if (!isolate) {
+        isolate = Isolate::New(create_params);
+    }
+    pl_metrics_register(this);
+    pl_sandbox_set_up(this);
+    pl_heap_set_up(this);
 
 #if defined(V8_PROFILE_RESET) && V8_PROFILE_RESET > 0
     double t1 = now_us();
@@ -283,6 +646,9 @@ void V8Context::set_up()
     /* Register callbacks to native functions in the template */
     pl_register_native_functions(this, object_template);
 
+    /* Register accessors for global Perl scalars bound to JS */
+    pl_bind_scalars_on_template(this, object_template);
+
     /* Create a new context and reset the persistent objects. */
     Local<Context> context = Context::New(isolate, 0, object_template);
     persistent_context->Reset(isolate, context);
@@ -297,13 +663,22 @@ void V8Context::set_up()
     /* Register console handlers. */
     pl_register_console_functions(this);
 
+    /* Register accessors for nested Perl scalars bound to JS */
+    pl_bind_scalars_on_context(this);
+
+    /* Install again all persistent values, without converting them */
+    pl_persist_install(this);
+
+    /* Start creating the next isolate, if we will recycle this one */
+    pl_recycle_set_up(this, create_params);
+
 #if defined(V8_PROFILE_RESET) && V8_PROFILE_RESET > 0
     double t2 = now_us();
     fprintf(stderr, "SET_UP: %5.0lf + %5.0lf = %5.0lf us\n", t1 - t0, t2 - t1, t2 - t0);
 #endif
 }
 
-void V8Context::tear_down()
+void V8Context::tear_down(bool dispose_in_background)
 {
     if (!inited) {
         return;
@@ -314,9 +689,21 @@ void V8Context::tear_down()
     double t0 = now_us();
 #endif
 
+    pl_lazy_tear_down(aTHX_ this);
+    pl_sync_tear_down(aTHX_ this);
+    pl_bind_tear_down(aTHX_ this);
     delete persistent_template;
     delete persistent_context;
-    isolate->Dispose();
+    pl_profiler_tear_down(this);
+    pl_watchdog_forget(this);
+    pl_sandbox_tear_down(this);
+    pl_heap_tear_down(this);
+    pl_metrics_unregister(this);
+    if (dispose_in_background) {
+        pl_recycle_dispose_isolate(this, isolate);
+    } else {
+        isolate->Dispose();
+    }
 
 #if defined(V8_PROFILE_RESET) && V8_PROFILE_RESET > 0
     double t1 = now_us();
@@ -334,6 +721,76 @@ void V8Context::reset()
     set_up();
 }
 
+void V8Context::recycle()
+{
+    const char* reason = recycle_reason;
+    double t0 = now_us();
+    recycle_reason = 0;
+    tear_down(true);
+    set_up();
+    double t1 = now_us();
+
+    pl_stats_add(aTHX_ this, "recycle", "count", 1);
+    pl_stats_add(aTHX_ this, "recycle", reason, 1);
+    pl_stats_add(aTHX_ this, "recycle", "elapsed_us", t1 - t0);
+    pl_metrics_recycle(reason);
+}
+
+/*
+ * Called when we start running a call from Perl, as opposed to a nested call
+ * made from a Perl callback while JS code is running.  Forget whatever state
+ * the previous call may have left behind if it did not unwind normally, and
+ * run the tasks V8 posted for the isolate while we were not using it.
+ */
+void V8Context::enter()
+{
+    if (recycle_reason && !pl_profiler_active(this)) {
+        recycle();
+    }
+    pl_watchdog_forget(this);
+    pl_monitor_resume();
+    stats_table->current = -1;
+    if (terminate_reason != PL_TERMINATE_NONE) {
+        pl_sandbox_cancel_termination(this);
+    }
+
+    Isolate::Scope isolate_scope(isolate);
+    HandleScope handle_scope(isolate);
+    pump_tasks();
+}
+
+/*
+ * Run the foreground tasks V8 posted for our isolate, such as the GC work
+ * requested by a memory pressure notification sent from the memory monitor
+ * thread; nobody else runs them for us.
+ */
+void V8Context::pump_tasks()
+{
+    while (v8::platform::PumpMessageLoop(platform.get(), isolate)) {
+    }
+}
+
+/*
+ * Croak with the error recorded by pl_fail, if any, discarding the value we
+ * were going to return.  Call this only once all the V8 scopes are closed.
+ */
+void V8Context::croak_on_failure(SV* ret)
+{
+    if (!pending_error) {
+        return;
+    }
+    SV* error = sv_2mortal(pending_error);
+    pending_error = 0;
+    SvREFCNT_dec(ret);
+    croak("%s", SvPV_nolen(error));
+}
+
+int V8Context::create_snapshot(const char* code, const char* path)
+{
+    V8Context::initialize_v8();
+    return pl_snapshot_create(aTHX_ code, path);
+}
+
 const char* get_data_path()
 {
     static const char* locations[] = {
@@ -376,6 +833,189 @@ const char* get_data_path()
     return ".";
 }
 
+/*
+ * Instead of letting V8 read the blob files into private buffers (which is
+ * what InitializeExternalStartupData does), map them read-only in memory, so
+ * that all processes on a host (and specially forked workers) share the same
+ * physical pages.  The mappings are never released, V8 uses them for as long
+ * as the process lives.  If any file cannot be mapped, return false so that
+ * the caller can fall back to the usual initialization.
+ */
+static bool initialize_blobs_mapped(const char* natives_path, const char* snapshot_path)
+{
+    static StartupData natives = { 0, 0 };
+    static StartupData snapshot = { 0, 0 };
+
+    size_t natives_size = 0;
+    const char* natives_data = map_file(natives_path, &natives_size);
+    size_t snapshot_size = 0;
+    const char* snapshot_data = map_file(snapshot_path, &snapshot_size);
+    if (!natives_data || !snapshot_data) {
+        unmap_file(natives_data, natives_size);
+        unmap_file(snapshot_data, snapshot_size);
+        return false;
+    }
+
+    natives.data = natives_data;
+    natives.raw_size = natives_size;
+    snapshot.data = snapshot_data;
+    snapshot.raw_size = snapshot_size;
+    V8::SetNativesDataBlob(&natives);
+    V8::SetSnapshotDataBlob(&snapshot);
+    return true;
+}
+
+/*
+ * Same thing for the ICU data file: V8 would read it into a private buffer, so
+ * we map it and hand it over to ICU ourselves.  This needs the ICU headers
+ * that match the ICU library V8 was built with, which Makefile.PL only uses
+ * (defining PL_HAVE_ICU_UDATA) when told where they are; without them, return
+ * false so that the caller can fall back to the usual initialization.
+ */
+static bool initialize_icu_mapped(const char* icu_path)
+{
+#if defined(PL_HAVE_ICU_UDATA)
+    size_t size = 0;
+    const char* data = map_file(icu_path, &size);
+    if (!data) {
+        return false;
+    }
+    UErrorCode err = U_ZERO_ERROR;
+    udata_setCommonData(data, &err);
+    if (U_FAILURE(err)) {
+        unmap_file(data, size);
+        return false;
+    }
+    /* the data must not be looked up anywhere else */
+    udata_setFileAccess(UDATA_ONLY_PACKAGES, &err);
+    return true;
+#else
+    UNUSED_ARG(icu_path);
+    return false;
+#endif
+}
+
+void V8Context::configure(HV* opt)
+{
+    if (instance_count) {
+        croak("V8 is already initialized, configure must be called before creating any instance\n");
+    }
+    if (!opt) {
+        return;
+    }
+
+    hv_iterinit(opt);
+    while (1) {
+        SV* value = 0;
+        I32 klen = 0;
+        char* kstr = 0;
+        HE* entry = hv_iternext(opt);
+        if (!entry) {
+            break; /* no more hash keys */
+        }
+        kstr = hv_iterkey(entry, &klen);
+        if (!kstr || klen < 0) {
+            continue; /* invalid key */
+        }
+        value = hv_iterval(opt, entry);
+        if (!value) {
+            continue; /* invalid value */
+        }
+        if (memcmp(kstr, V8_CFG_NAME_PREFORK, klen) == 0) {
+            prefork_mode = SvTRUE(value) ? 1 : 0;
+            continue;
+        }
+        if (memcmp(kstr, V8_CFG_NAME_THREAD_POOL_SIZE, klen) == 0) {
+            int param = SvIV(value);
+            thread_pool_size = param > 0 ? param : 0;
+            continue;
+        }
+        if (memcmp(kstr, V8_CFG_NAME_IDLE_TASKS, klen) == 0) {
+            idle_tasks = SvTRUE(value) ? 1 : 0;
+            continue;
+        }
+        if (memcmp(kstr, V8_CFG_NAME_PROFILE, klen) == 0) {
+            const char* name = SvPV_nolen(value);
+            int n = sizeof(profiles) / sizeof(profiles[0]);
+            int j = 0;
+            for (j = 0; j < n; ++j) {
+                if (strcmp(name, profiles[j].name) == 0) {
+                    break;
+                }
+            }
+            if (j >= n) {
+                croak("Unknown profile %s\n", name);
+            }
+            profile = j;
+            V8::SetFlagsFromString(profiles[j].flags, strlen(profiles[j].flags));
+            continue;
+        }
+        croak("Unknown option %*.*s\n", (int) klen, (int) klen, kstr);
+    }
+}
+
+void V8Context::set_flags(const char* flags)
+{
+    if (instance_count) {
+        croak("V8 is already initialized, set_flags must be called before creating any instance\n");
+    }
+    V8::SetFlagsFromString(flags, strlen(flags));
+    pl_recycle_parse_flags(flags);
+}
+
+/*
+ * The threads in the V8 platform do not survive a fork: the child would
+ * inherit a platform whose worker threads do not exist, and any task posted
+ * to them would never run.  In prefork mode V8 never uses background threads,
+ * so it is safe to initialize V8 (and load code) in a parent process and use
+ * it in forked children.
+ */
+void V8Context::prepare_fork()
+{
+    if (instance_count && !prefork_mode) {
+        croak("V8 was not initialized in prefork mode, it cannot be used across a fork\n");
+    }
+
+    /*
+     * Threads do not survive a fork.  The watchdog is started again when
+     * needed; the memory monitor is started again, with the same options, by
+     * after_fork_child or by the next call into V8 in either process.
+     */
+    pl_watchdog_stop();
+    pl_monitor_suspend();
+    pl_recycle_wait();
+    fork_parent_pid = getpid();
+}
+
+void V8Context::after_fork_child()
+{
+    if (!fork_parent_pid) {
+        croak("after_fork_child called without calling prepare_fork first\n");
+    }
+    if (fork_parent_pid == getpid()) {
+        croak("after_fork_child must be called in the child process\n");
+    }
+    fork_parent_pid = 0;
+
+    /* start again right away the threads that prepare_fork stopped */
+    pl_monitor_resume();
+}
+
+SV* V8Context::metrics_text()
+{
+    return pl_metrics_text(aTHX);
+}
+
+int V8Context::start_memory_monitor(HV* opt)
+{
+    return pl_monitor_start(aTHX_ opt);
+}
+
+void V8Context::stop_memory_monitor()
+{
+    pl_monitor_stop();
+}
+
 void V8Context::initialize_v8()
 {
     if (instance_count++) {
@@ -388,16 +1028,29 @@ void V8Context::initialize_v8()
     /* initialize ICU, make it point to that path */
     char icu_dtl_data[1024];
     sprintf(icu_dtl_data, "%s/%s", data_path, ICU_DTL_DATA);
-    V8::InitializeICUDefaultLocation(PROGRAM_NAME, icu_dtl_data);
+    if (!initialize_icu_mapped(icu_dtl_data)) {
+        V8::InitializeICUDefaultLocation(PROGRAM_NAME, icu_dtl_data);
+    }
 
     /* initialize V8 with the appropriate blob files */
     char natives_blob[1024];
     char snapshot_blob[1024];
     sprintf(natives_blob, "%s/%s", data_path, V8_NATIVES_BLOB);
     sprintf(snapshot_blob, "%s/%s", data_path, V8_SNAPSHOT_BLOB);
-    V8::InitializeExternalStartupData(natives_blob, snapshot_blob);
+    if (!initialize_blobs_mapped(natives_blob, snapshot_blob)) {
+        V8::InitializeExternalStartupData(natives_blob, snapshot_blob);
+    }
 
-    platform = v8::platform::NewDefaultPlatform();
+    int pool_size = thread_pool_size;
+    if (prefork_mode) {
+        /* make sure V8 never posts tasks to background threads */
+        V8::SetFlagsFromString(V8_PREFORK_FLAGS, sizeof(V8_PREFORK_FLAGS) - 1);
+        pool_size = V8_PREFORK_POOL_SIZE;
+    }
+    v8::platform::IdleTaskSupport idle_task_support = idle_tasks
+                                                    ? v8::platform::IdleTaskSupport::kEnabled
+                                                    : v8::platform::IdleTaskSupport::kDisabled;
+    platform = v8::platform::NewDefaultPlatform(pool_size, idle_task_support);
     V8::InitializePlatform(platform.get());
     V8::Initialize();
 }
@@ -9,6 +9,18 @@
 #define V8_OPT_NAME_SAVE_MESSAGES     "save_messages"
 #define V8_OPT_NAME_MAX_MEMORY_BYTES  "max_memory_bytes"
 #define V8_OPT_NAME_MAX_TIMEOUT_US    "max_timeout_us"
+#define V8_OPT_NAME_MAX_CONVERT_NODES "max_convert_nodes"
+#define V8_OPT_NAME_MAX_CONVERT_BYTES "max_convert_bytes"
+#define V8_OPT_NAME_SNAPSHOT          "snapshot"
+#define V8_OPT_NAME_STATS_SAMPLE_RATE "stats_sample_rate"
+#define V8_OPT_NAME_RECYCLE_AFTER_EVALS      "recycle_after_evals"
+#define V8_OPT_NAME_RECYCLE_AFTER_SECONDS    "recycle_after_seconds"
+#define V8_OPT_NAME_RECYCLE_ABOVE_HEAP_BYTES "recycle_above_heap_bytes"
+
+#define V8_CFG_NAME_PREFORK           "prefork"
+#define V8_CFG_NAME_THREAD_POOL_SIZE  "thread_pool_size"
+#define V8_CFG_NAME_IDLE_TASKS        "idle_tasks"
+#define V8_CFG_NAME_PROFILE           "profile"
 
 #define V8_OPT_FLAG_GATHER_STATS      0x01
 #define V8_OPT_FLAG_SAVE_MESSAGES     0x02
@@ -17,6 +29,8 @@
 
 using namespace v8;
 
+struct StatsTable;
+
 class V8Context {
     public:
         V8Context(HV* opt);
@@ -24,25 +38,50 @@ class V8Context {
 
         void reset();
 
-        SV* get(const char* name);
+        static int create_snapshot(const char* code, const char* path);
+
+        static void configure(HV* opt);
+        static void set_flags(const char* flags);
+        static void prepare_fork();
+        static void after_fork_child();
+        static SV* metrics_text();
+        static int start_memory_monitor(HV* opt = 0);
+        static void stop_memory_monitor();
+
+        SV* get(const char* name, HV* opt = 0);
+        SV* get_many(AV* names);
         SV* exists(const char* name);
         SV* typeof(const char* name);
         SV* instanceof(const char* oname, const char* cname);
 
         void set(const char* name, SV* value);
+        void set_many(HV* values);
+        void set_lazy(const char* name, SV* func);
+        void set_persistent(const char* name, SV* value);
+        void sync(const char* name, SV* value);
+        void bind(const char* name, SV* ref);
+        void bind_scalar(const char* name, SV* ref);
+        void register_class(const char* package, AV* methods = 0);
         void remove(const char* name);
 
         SV* eval(const char* code, const char* file = 0);
+        void eval_void(const char* code, const char* file = 0);
 
         SV* dispatch_function_in_event_loop(const char* func);
 
         SV* global_objects();
 
         int run_gc();
+        int idle_gc(double deadline_ms);
+        void memory_pressure(const char* level);
+
+        void start_profiling(const char* name, HV* opt = 0);
+        SV* stop_profiling(const char* name);
 
         HV* get_version_info();
 
         HV* get_stats();
+        SV* get_heap_stats();
         void reset_stats();
 
         HV* get_msgs();
@@ -51,27 +90,59 @@ class V8Context {
         Isolate* isolate;
         Persistent<Context>* persistent_context;
         Persistent<ObjectTemplate>* persistent_template;
+        Persistent<ObjectTemplate>* bind_hash_template;
+        Persistent<ObjectTemplate>* bind_array_template;
 
         uint64_t flags;
         HV* version;
         HV* stats;
+        StatsTable* stats_table;
         HV* msgs;
+        HV* classes;
+        unsigned long sync_generation;
         long pagesize_bytes;
-        size_t max_allocated_bytes;  /* unused for now */
-        double max_timeout_us;       /* unused for now */
+        size_t max_allocated_bytes;  /* zero means no limit */
+        size_t initial_heap_limit;   /* before V8 asked us to raise it */
+        int terminate_reason;        /* why we terminated JS execution */
+        size_t heap_used_before_gc;  /* when the current GC started */
+        double gc_started_us;        /* when the current GC started */
+        double heap_freed_bytes;     /* by all GCs since the isolate was created */
+        double max_timeout_us;       /* zero means no limit */
+        int watchdog_depth;          /* nested calls running JS code */
+        bool watchdog_armed;         /* deadline is waiting in the watchdog */
+        int64_t watchdog_deadline;   /* when the deadline is due, in clock ticks */
+        long max_convert_nodes;      /* zero means no limit */
+        long max_convert_bytes;      /* zero means no limit */
+        long recycle_after_evals;    /* zero means never */
+        double recycle_after_seconds;  /* zero means never */
+        size_t recycle_above_heap_bytes;  /* zero means never */
+        long recycle_evals;          /* evals since the isolate was created */
+        double recycle_started_us;   /* when the isolate was created */
+        const char* recycle_reason;  /* if not null, recycle on next call */
+        SV* pending_error;           /* to croak with once out of V8, see pl_fail */
 
         static uint64_t GetTypeFlags(const Local<Value>& v);
     private:
         int inited;
         Isolate::CreateParams create_params;
+        StartupData snapshot_blob;
 
         static void initialize_v8();
         static void terminate_v8();
         static int instance_count;
+        static int prefork_mode;
+        static int thread_pool_size;  /* zero means let V8 decide */
+        static int idle_tasks;
+        static int profile;           /* index into the profile table, or -1 */
+        static long fork_parent_pid;
         static std::unique_ptr<Platform> platform;
 
         void set_up();
-        void tear_down();
+        void tear_down(bool dispose_in_background = false);
+        void recycle();
+        void enter();
+        void pump_tasks();
+        void croak_on_failure(SV* ret = 0);
         void GetVersionInfo();
 };
 
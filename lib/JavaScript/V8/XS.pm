@@ -61,12 +61,31 @@ Version 0.000016
     };
     my $vm = JavaScript::V8::XS->new($options);
 
+    JavaScript::V8::XS->create_snapshot($library_code, '/tmp/lib.snapshot');
+    my $fast = JavaScript::V8::XS->new({ snapshot => '/tmp/lib.snapshot' });
+
     $vm->set('global_name', [1, 2, 3]);
     my $aref = $vm->get('global_name');
     $vm->remove('global_name');
 
     $vm->set('my.object.slot', { foo => [ 4, 5 ] });
     my $href = $vm->get('my.object.slot');
+    my $part = $vm->get('my.big.list', { fields => [ 'id' ], slice => [ 0, 10 ] });
+
+    $vm->set_many({ foo => 1, 'my.object.bar' => [ 2, 3 ] });
+    my $values = $vm->get_many([ 'foo', 'my.object.bar' ]);
+
+    $vm->set_lazy('zipcodes', sub { load_zipcodes() });
+    $vm->set_persistent('countries', $countries_hashref);  # still there after reset
+
+    $vm->sync('state', $state_hashref);  # call again after changing $state_hashref
+
+    $vm->bind('config', $big_config_hashref);
+    $vm->bind_scalar('counter', \$counter);
+
+    $vm->register_class('My::Class');
+    $vm->set('obj', My::Class->new());
+    my $result = $vm->eval('obj.some_method(1, 2)');
 
     if ($vm->exists('my.object.slot')) { ... }
 
@@ -79,10 +98,12 @@ Version 0.000016
     # from the Perl function will be converted to JS values.
     $vm->set('function_name', sub { my @args = @_; return \@args; });
     my $returned = $vm->eval('function_name(my.object.slot)');
+    $vm->eval_void('var big = build_huge_object()');
 
     $vm->dispatch_function_in_event_loop('function_name');
 
     my $stats_href = $vm->get_stats();
+    my $heap_href = $vm->get_heap_stats();
     $vm->reset_stats();
 
     my $msgs_href = $vm->get_msgs();
@@ -128,6 +149,12 @@ and C<snapshot_blob.bin>)
 
 =back
 
+The V8 blobs and the ICU data file are mapped read-only in memory (instead of
+being read into private buffers), so all processes on a host, and in
+particular workers forked from a common parent, share the same pages.  The ICU
+data file is only mapped if C<V8_ICU_INCLUDE_DIR> pointed C<Makefile.PL> to the
+ICU header files matching the ICU library V8 was built with.
+
 =head1 METHODS/ATTRIBUTES
 
 =head2 new
@@ -141,6 +168,13 @@ The XS object will gather statistics about elapsed time and memory usage for
 several of its operations.  You can then retrieve the stats by calling
 C<get_stats>.
 
+=head3 stats_sample_rate
+
+When gathering statistics, only measure one in every N calls to each
+operation, where N is the value for this option; the default is 1, meaning
+every call is measured.  All calls are still counted.  Use this to reduce the
+(already small) overhead of gathering statistics in hot loops.
+
 =head3 save_messages
 
 Any message printed to the JavaScript console will instead be saved in a
@@ -148,6 +182,206 @@ hashref, where each key represents a "target" for the message (for example,
 C<stdout> or C<stderr>).  You can then retrieve the messages by calling
 C<get_msgs>.
 
+=head3 max_memory_bytes
+
+The maximum amount of memory that the JavaScript code can use, in bytes; it
+can never be less than 16 MB.  This limits the size of the V8 heap, and also
+(separately) the total size of all live C<ArrayBuffer> objects.  When the code
+gets near the heap limit, it is terminated and the error C<Error: allocation
+failure> is reported, instead of letting V8 abort the whole process; the
+instance can then be used to run code again.  Allocating an C<ArrayBuffer>
+over the limit throws a C<RangeError>.  By default there is no limit.
+
+=head3 max_timeout_us
+
+The maximum time, in microseconds, that the JavaScript code run by each
+C<eval> call, each dispatched function and each event loop callback may take;
+it can never be less than half a second.  When the code runs for longer than
+that, it is terminated and the error C<RangeError: execution timeout> is
+reported; the instance can then be used to run code again.  The time limit is
+enforced by a single watchdog thread for the whole process.  By default there
+is no limit.
+
+=head3 recycle_after_evals
+
+=head3 recycle_after_seconds
+
+=head3 recycle_above_heap_bytes
+
+A policy to transparently replace the V8 isolate with a fresh one, after a
+given number of calls to C<eval>, C<eval_void> or
+C<dispatch_function_in_event_loop>, after a given number of seconds, or once
+the used heap grows above a given size (whichever comes first).  This gets rid
+of any garbage that long-lived instances accumulate over time.
+
+The check is done after running code, and the isolate is replaced at the
+beginning of the next call.  Recycling is just like calling C<reset>: values
+set with C<set_persistent>, scalars bound with C<bind_scalar>, registered
+classes and the contents of the C<snapshot> are there in the new isolate, but
+any other state is lost.  The new isolate is created in a background thread
+ahead of time, and the old one is disposed of in the background as well, so
+that recycling does not stall the call that triggers it.
+
+Each recycling is counted in the C<recycle> entry of the stats, together with
+the reason and the time it took; these are recorded even if C<gather_stats> is
+not enabled.
+
+=head3 max_convert_nodes
+
+The maximum number of values (scalars, arrays and objects) that a single
+conversion from JavaScript to Perl data may create; if a conversion would
+create more than this, it dies instead of building a runaway Perl structure.
+This applies to C<get>, the results of C<eval> and the arguments passed to
+Perl callbacks.  Zero (the default) means no limit.
+
+=head3 max_convert_bytes
+
+The maximum number of bytes (in strings and hash keys) that a single
+conversion from JavaScript to Perl data may create; if a conversion would
+create more than this, it dies.  Zero (the default) means no limit.
+
+=head3 snapshot
+
+The path to a startup snapshot file created with C<create_snapshot>.  The new
+instance (and any instance it is reset to) boots from that snapshot, so all
+the JavaScript code that was run to create it is already loaded.
+
+=head2 create_snapshot
+
+    JavaScript::V8::XS->create_snapshot($code, $path);
+
+A class method that runs some JavaScript code in a fresh context and writes a
+startup snapshot with the resulting state to a file; it returns the size of
+the snapshot.  Use the C<snapshot> option for C<new> to create instances from
+this file; loading a snapshot is usually much faster than running the same
+code again.
+
+The code is run before the C<console> object and the event loop functions
+(C<setTimeout> and friends) are available, so it should only use them inside
+functions called later.  The snapshot can only be used with the same build of
+V8 that created it.
+
+The snapshot is written to a temporary file (the path plus C<.tmp>) which is
+then renamed, so it is safe to replace a snapshot that running processes have
+loaded.
+
+=head2 configure
+
+    JavaScript::V8::XS->configure({ thread_pool_size => 2, idle_tasks => 0 });
+
+A class method to set process-wide options for V8; it must be called before
+creating the first instance (or the first snapshot), and dies otherwise.  The
+options are:
+
+=head3 prefork
+
+Initialize V8 so that it can be used across a C<fork>: V8 is told not to use
+any background threads (which would not exist in the child processes), at the
+price of doing all its work (for example, garbage collection) in the calling
+thread.  This allows a preforking server to create instances and load code in
+the parent process, and let the children share those pages copy-on-write.
+
+=head3 thread_pool_size
+
+The number of background threads V8 uses for tasks such as garbage collection
+and optimizing compilation.  By default V8 uses one thread per core in the
+host, which oversubscribes the CPUs when running many processes per host.  In
+C<prefork> mode this is always 1 (and the thread is never used).
+
+=head3 idle_tasks
+
+Whether V8 may post idle tasks (for example, incremental garbage collection
+work done while the process is idle).  Idle tasks are disabled by default.
+
+=head3 profile
+
+A named runtime profile, which sets some V8 flags and the heap constraints for
+all instances created afterwards.  It can be one of:
+
+=over 4
+
+=item * C<low_memory>: optimize code for size, do garbage collection in the
+main thread, and use a small heap (1 MB semi-spaces, 128 MB old space).
+
+=item * C<throughput>: use a large young generation (16 MB semi-spaces), so
+that scavenges happen less often.
+
+=item * C<latency>: use a small young generation (2 MB semi-spaces), so that
+each scavenge pause is short.
+
+=back
+
+Flags set with C<set_flags> after calling C<configure> override those of the
+profile.
+
+=head2 set_flags
+
+    JavaScript::V8::XS->set_flags('--jitless --max-old-space-size=256');
+
+A class method that passes a string with flags straight to V8, exactly as if
+they were given in the command line of C<d8>.  It must be called before
+creating the first instance, and dies otherwise.  V8 ignores (with a warning)
+any flags it does not know about.
+
+=head2 prepare_fork
+
+=head2 after_fork_child
+
+    JavaScript::V8::XS->prepare_fork();
+    my $pid = fork();
+    JavaScript::V8::XS->after_fork_child() if $pid == 0;
+
+Class methods to call right before forking, and in the child process right
+after forking.  C<prepare_fork> dies if V8 was already initialized without the
+C<prefork> option; it waits for any background work and stops the threads
+this module runs (see C<start_memory_monitor>), because threads do not survive
+a fork.  C<after_fork_child> checks that it is called in a child of the
+process that called C<prepare_fork>, and dies otherwise; then it starts again
+the threads that were stopped, instead of waiting for the next call on an XS
+object to do it.
+
+=head2 start_memory_monitor
+
+    JavaScript::V8::XS->start_memory_monitor({
+        interval_ms => 500,
+        moderate    => 0.75,
+        critical    => 0.90,
+    });
+
+Class method that starts a thread which periodically checks the memory usage
+of the cgroup (v2 or v1) the process runs in, against its memory limit.  When
+the usage crosses one of the thresholds, given as fractions of the limit, all
+live XS objects are told about the new memory pressure level, just like
+calling C<memory_pressure> on each of them, so that V8 shrinks the JavaScript
+heaps before the container runs out of memory.  Dropping back below the
+moderate threshold sets the level back to C<none>.
+
+The options are C<interval_ms> (default 1000), C<moderate> (default 0.80) and
+C<critical> (default 0.95).  You can also pass C<current_file> and
+C<max_file>, to read the usage and limit from other files.
+
+Returns true if the monitor was started, or false if no cgroup memory limit
+could be found (including a cgroup whose limit is C<max>).  Each change of
+level is recorded in the stats for each object, under category
+C<memory_monitor> (even without C<gather_stats>), and in the output of
+C<metrics_text>.  Calling this again restarts the monitor with the new
+options.
+
+V8 does the work for a notification coming from the monitor thread the next
+time the object is used: at the start of the next call on it (and after each
+run of the event loop).  An object that is not used at all keeps its heap
+until its next call, so if you keep idle objects around, call C<idle_gc> or
+C<memory_pressure> on them from time to time.
+
+The monitor thread is stopped by C<prepare_fork>, and started again with the
+same options by C<after_fork_child> in the child, and by the next call on any
+XS object in either process.  Call C<stop_memory_monitor> in the processes
+that should not run it.
+
+=head2 stop_memory_monitor
+
+Class method that stops the memory monitor thread, if it is running.
+
 =head2 set
 
 Give a value to a given JavaScript variable or object slot.
@@ -163,6 +397,113 @@ coderef will be properly converted into equivalent Perl values; likewise, any
 values returned from the Perl coderef back to JavaScript will be also converted
 into equivalent JavaScript values.
 
+If the Perl coderef dies, the JavaScript code that called it is stopped (with
+an exception that it should not try to catch), and the method that was running
+that JavaScript code (C<eval>, C<get>, ...) dies with the error.
+
+=head2 set_many
+
+Give values to several JavaScript variables or object slots at once; the
+argument is a hashref mapping names to Perl values.  This is equivalent to
+calling C<set> for each of them, but all the work is done in a single entry
+into V8, and Perl data shared among the values is converted only once (and
+becomes a single JavaScript object).
+
+=head2 get_many
+
+Get the values stored in several JavaScript variables or object slots at
+once; the argument is an arrayref of names, and the result is a hashref
+mapping each name to its value (C<undef> for missing names).  As with
+C<set_many>, all the work is done in a single entry into V8, and JavaScript
+objects shared among the values are converted only once.
+
+=head2 set_lazy
+
+Set a variable or object slot whose value is computed only when JavaScript
+first reads it, by calling a given Perl coderef (with no arguments) and
+converting what it returns.  The converted value then replaces the lazy
+property, so the coderef is called at most once.  If the property is never
+read, the coderef is never called.
+
+=head2 set_persistent
+
+Like C<set>, but the value is also kept so that it is installed again every
+time the context is C<reset>.  The Perl data is converted only once; after a
+reset the stored JavaScript value is copied straight into the new context,
+without any conversion from Perl.  Later changes to the Perl data are not seen
+by JavaScript, so this is meant for immutable reference data.
+
+Only plain data can be persisted: values that include functions cause an
+exception.  Calling C<set_persistent> again with the same name replaces the
+stored value.
+
+=head2 sync
+
+Give a value to a given JavaScript variable or object slot, like C<set>, but
+remember which JavaScript object was created for each Perl hash and array.
+
+When called again for the same name, typically after changing some parts of
+the Perl data, the same JavaScript objects are reused, and only the keys and
+elements whose values changed are written.  Unchanged parts of the data keep
+their identity in JavaScript, and no garbage is created for them, which makes
+this much cheaper than a new C<set> for large, mostly unchanged data.
+
+Hashes and arrays are identified by their address, so the data must be
+changed in place for this to work; hashes and arrays that are no longer
+reachable from the Perl data are forgotten on each call.
+
+=head2 bind
+
+Expose a Perl hashref or arrayref to JavaScript under a given variable or
+object slot, without copying it.
+
+Contrary to C<set>, no conversion happens up front: JavaScript gets an object
+whose properties are looked up in the underlying Perl hash or array each time
+they are accessed, and only the values that are actually read get converted.
+Nested hashes and arrays are exposed in the same way when they are accessed.
+Changes done to the data in Perl are immediately visible in JavaScript, and
+values assigned from JavaScript are stored back in the Perl data.
+
+A bound array is not a real JavaScript array, but it has a C<length> and the
+methods from C<Array.prototype>.  Getting a bound value back with C<get>
+returns the original Perl data.
+
+Storing from JavaScript into a locked hash (see L<Hash::Util>) a key it does
+not allow, or into a read-only array, throws a C<TypeError> in JavaScript, and
+the call that ran that code dies with the same error.
+
+=head2 bind_scalar
+
+Expose a Perl scalar, given as a reference, to JavaScript under a given
+variable or object slot, using a native accessor.
+
+Reading the variable from JavaScript converts the current value of the Perl
+scalar, and assigning to it from JavaScript stores the converted value in the
+Perl scalar; there is no need to call C<set> after changing the value in Perl.
+Binding the same name again makes it refer to the new scalar.  Bound scalars
+survive a C<reset>.
+
+Assigning from JavaScript to a bound read-only scalar (such as C<\1>) throws a
+C<TypeError> in JavaScript, and the call that ran that code dies with the same
+error.
+
+=head2 register_class
+
+Register a Perl package, so that any of its instances passed to JavaScript
+(with C<set>, as a return value, etc.) appear as JavaScript objects whose
+methods call the corresponding Perl methods, instead of being flattened into
+plain data.  Arguments and return values of these methods are converted as
+usual.  Getting one of these objects back with C<get> returns the original
+Perl object.
+
+By default, all subs defined in the package are exposed as methods, except
+those whose name starts with an underscore or is all uppercase (such as
+C<DESTROY>).  Inherited methods are not exposed by default; you can give an
+optional arrayref with the exact list of method names to expose.
+
+Only objects blessed exactly into a registered package are handled in this
+way; register a package before passing any of its instances to JavaScript.
+
 =head2 get
 
 Get the value stored in a JavaScript variable or object slot.
@@ -171,6 +512,25 @@ The JavaScript value is converted into an equivalent Perl value, so you can
 freely pass nested structures (hashes of arrays of hashes) and they will be
 handled correctly.
 
+You can give an optional hashref with options to limit how much of the value
+gets converted, which saves time and memory when you only need a small part
+of a large value:
+
+=over 4
+
+=item * C<fields>: an arrayref of keys; only these keys will be converted for
+the value (if it is an object) or for each of its elements (if it is an
+array).
+
+=item * C<depth>: the maximum number of nested levels of arrays / objects that
+will be converted; deeper arrays / objects are returned as C<undef>.
+
+=item * C<slice>: an arrayref with an offset and an optional count; only this
+range of elements will be converted for the value (if it is an array).  A
+negative offset counts from the end of the array.
+
+=back
+
 =head2 remove
 
 Remove a JavaScript variable or object slot.
@@ -204,6 +564,12 @@ method is invoked; in the future this might be split into separate functions.
 
 Any returned values will be treated in the same way as a call to C<get>.
 
+=head2 eval_void
+
+Same as C<eval>, but the completion value of the code is discarded instead of
+being converted into Perl data.  Use this when you do not need that value,
+especially if it could be a large object.
+
 =head2 dispatch_function_in_event_loop
 
 Run a JavaScript function inside an event loop, and wait until all timers have
@@ -219,6 +585,103 @@ of JavaScript code:
 Return a hashref with the statistics gathered as a result of creating the XS
 object with option C<gather_stats> set to true.
 
+For each operation, C<calls> is the number of times it was called and
+C<samples> is how many of those calls were measured (see option
+C<stats_sample_rate>); the data below is only present once at least one call
+was measured.  For the last measured call, C<elapsed_us> is the wall
+clock time it took, C<cpu_us> is the CPU time used by the calling thread, and
+C<memory_bytes> is the number of bytes it allocated in the V8 heap (including
+any memory that was garbage collected during the operation).
+
+The times for all measured calls are also aggregated: C<elapsed_us_count>,
+C<elapsed_us_sum>, C<elapsed_us_min> and C<elapsed_us_max>, plus the
+percentiles C<elapsed_us_p50>, C<elapsed_us_p90>, C<elapsed_us_p99> and
+C<elapsed_us_p999>.  These come from a histogram with logarithmic buckets, so
+they are accurate to within about 12%.
+
+Besides the operations you call directly, there are some categories for things
+that happen while running them; they have the same elapsed time data, but no
+C<cpu_us> or C<memory_bytes>:
+
+=over 4
+
+=item * C<convert>: converting data between Perl and JavaScript.
+
+=item * C<callback>: running Perl code called from JavaScript.
+
+=item * C<gc>: garbage collections in the V8 heap.  These are also split by
+type of collection, in categories C<gc_scavenge> (young generation),
+C<gc_mark_compact> (full collection), C<gc_incremental> (incremental marking
+steps) and C<gc_weak_callbacks>.
+
+=back
+
+Each operation also has C<gc_count> and C<gc_us>, the number of garbage
+collections that happened while it was running and the total time they took,
+so you can tell when a slow call was actually waiting for the collector.
+
+The statistics are kept in a fixed table inside the XS object and are only
+converted into Perl data when you call this method, so gathering them is cheap.
+
+=head2 get_heap_stats
+
+    my $heap = $vm->get_heap_stats();
+    printf("used %d of %d bytes\n",
+           $heap->{heap}{used_heap_size}, $heap->{heap}{heap_size_limit});
+
+Return a hashref with the current statistics for the V8 heap of this instance,
+as reported by V8:
+
+=over 4
+
+=item * C<heap>: totals for the whole heap, such as C<total_heap_size>,
+C<used_heap_size>, C<heap_size_limit>, C<malloced_memory> and
+C<number_of_native_contexts>.
+
+=item * C<spaces>: a hashref keyed by heap space name (such as
+C<new_space> or C<old_space>), with C<space_size>, C<space_used_size>,
+C<space_available_size> and C<physical_space_size> for each space.
+
+=item * C<code>: C<code_and_metadata_size> and C<bytecode_and_metadata_size>.
+
+=item * C<external_memory>: memory allocated outside the heap but kept alive
+by JavaScript objects, such as the contents of C<ArrayBuffer> objects.
+
+=back
+
+This is always available, regardless of the C<gather_stats> option.
+
+=head2 metrics_text
+
+    my $text = JavaScript::V8::XS->metrics_text();
+
+Class method that returns a string with metrics for all the XS objects in the
+process, in the OpenMetrics text exposition format (which Prometheus can
+scrape); every metric name starts with C<v8xs_>.  It includes:
+
+=over 4
+
+=item * C<v8xs_operation_calls_total> and the C<v8xs_operation_seconds>
+histogram, labeled by operation (C<op>); only objects created with option
+C<gather_stats> contribute to these.
+
+=item * C<v8xs_recycles_total>, labeled by C<reason>.
+
+=item * C<v8xs_contexts>, and the sizes of the V8 heaps of all live objects,
+as a whole and by heap space (C<space>).
+
+=item * C<v8xs_timers_pending>.
+
+=item * C<v8xs_cgroup_memory_current_bytes>, C<v8xs_cgroup_memory_max_bytes>
+and C<v8xs_memory_pressure_events_total> (labeled by C<level>), from the
+memory monitor (see C<start_memory_monitor>).
+
+=back
+
+The operation metrics are kept in process-wide atomic counters that are
+updated together with the stats for each object, so calling this method is
+cheap.
+
 =head2 reset_stats
 
 Reset the accumulated statistics, as if the XS object had just been created.
@@ -252,6 +715,72 @@ will appear first in the returned stacktrace information.
 Run at least one round of the JavaScript garbage collector, and return the
 number of rounds that were effectively run.
 
+This runs full, stop-the-world collections; for large heaps, consider using
+C<idle_gc> or C<memory_pressure> instead.
+
+=head2 idle_gc
+
+    # we expect the next request in about 10 ms
+    $vm->idle_gc(10);
+
+Tell V8 that the caller will be idle for the given number of milliseconds, so
+that it can use that time to do incremental garbage collection work.  There is
+no guarantee that V8 will finish before the deadline.  Returns true if V8 has
+no more cleanup to do for now, in which case there is no point in calling this
+again until more JavaScript code has run.
+
+If the class was configured with C<idle_tasks>, any time left before the
+deadline is used to run the idle tasks posted by V8.
+
+=head2 memory_pressure
+
+    $vm->memory_pressure('moderate');
+
+Tell V8 about the memory pressure in the system, which can be C<none>,
+C<moderate> or C<critical>.  With a moderate level, V8 speeds up incremental
+garbage collection, at the cost of more latency; with a critical level, it
+runs a full garbage collection right away.  Setting the level back to C<none>
+restores the normal behaviour.
+
+=head2 start_profiling
+
+    $vm->start_profiling('render', {
+        sampling_interval_us => 100,
+        path                 => '/tmp/render.cpuprofile',
+        folded               => '/tmp/render.folded',
+    });
+
+Start sampling the JavaScript code run by this object with the V8 CPU
+profiler, under the given name; several profiles with different names can run
+at the same time.  The options are:
+
+=over 4
+
+=item * C<sampling_interval_us>: the time between samples, in microseconds;
+this applies to profiles started from now on.
+
+=item * C<path>: where to write the profile when it is stopped; by default,
+the profile name followed by C<.cpuprofile>.
+
+=item * C<folded>: if given, where to also write the profile as folded stacks
+(one line per stack, with the number of samples for it), which is the input
+format for most flame graph tools.
+
+=back
+
+While there are profiles running, the object is not recycled (see
+C<recycle_after_evals> and friends); it is recycled on the first call after
+the last profile is stopped.  Resetting the object discards any running
+profiles.
+
+=head2 stop_profiling
+
+    my $path = $vm->stop_profiling('render');
+
+Stop the profile with the given name and write it as a JSON file in the format
+used by Chrome DevTools (which can load it in its Performance panel), plus the
+folded stacks if requested.  Returns the path of the JSON file.
+
 =head2 get_version_info
 
 Return a hashref with version information.
@@ -0,0 +1,790 @@
+#include <map>
+#include <string>
+#include <vector>
+#include "pl_v8.h"
+#include "pl_stats.h"
+#include "pl_bind.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+#define BIND_FIELD_TAG    0
+#define BIND_FIELD_DATA   1
+#define BIND_FIELD_COUNT  2
+
+#define BIND_KEY_MAX     32  /* enough for any array index as a string */
+
+/* the address of this variable identifies our wrappers */
+static int bind_tag;
+
+struct BindData {
+    BindData(V8Context* ctx, SV* container) :
+        ctx(ctx), ref(newRV_inc(container)) {}
+
+    V8Context* ctx;
+    SV* ref;                    /* reference to the wrapped HV / AV */
+    Persistent<Object> handle;  /* weak handle to the JS wrapper */
+};
+
+/*
+ * All live wrappers, keyed by context and wrapped Perl container.  This allows
+ * us to return the same JS object when the same container is accessed again,
+ * and to release everything when a context is torn down.
+ */
+typedef std::pair<V8Context*, void*> BindKey;
+typedef std::map<BindKey, BindData*> BindMap;
+static BindMap bind_map;
+
+struct ClassData {
+    Persistent<FunctionTemplate> templ;  /* constructor, with methods in its prototype */
+    std::vector<std::string> methods;    /* method names, referenced by each method */
+};
+
+/*
+ * FunctionTemplates for registered Perl classes, keyed by context and package
+ * name.  They are created once per package (when the first instance of that
+ * package is passed to JS), and released when a context is torn down.
+ */
+typedef std::pair<V8Context*, std::string> ClassKey;
+typedef std::map<ClassKey, ClassData*> ClassMap;
+static ClassMap class_map;
+
+struct ScalarData {
+    ScalarData(V8Context* ctx, SV* ref) :
+        ctx(ctx), ref(newSVsv(ref)) {}
+
+    V8Context* ctx;
+    SV* ref;  /* reference to the bound Perl scalar */
+};
+
+/*
+ * Perl scalars bound to JS accessors, keyed by context and JS name.  These
+ * survive a reset (the accessors are installed again in the new context), and
+ * are released when the context is destroyed.
+ */
+typedef std::pair<V8Context*, std::string> ScalarKey;
+typedef std::map<ScalarKey, ScalarData*> ScalarMap;
+static ScalarMap scalar_map;
+
+static BindData* get_bind_data(const Local<Object>& object)
+{
+    if (object->InternalFieldCount() != BIND_FIELD_COUNT) {
+        return 0;
+    }
+    if (object->GetAlignedPointerFromInternalField(BIND_FIELD_TAG) != &bind_tag) {
+        return 0;
+    }
+    return (BindData*) object->GetAlignedPointerFromInternalField(BIND_FIELD_DATA);
+}
+
+static void bind_data_release(const WeakCallbackInfo<BindData>& info)
+{
+    dTHX;
+    BindData* data = info.GetParameter();
+    SvREFCNT_dec(data->ref);
+    delete data;
+}
+
+static void bind_data_weak(const WeakCallbackInfo<BindData>& info)
+{
+    BindData* data = info.GetParameter();
+    bind_map.erase(BindKey(data->ctx, SvRV(data->ref)));
+    data->handle.Reset();
+
+    /* releasing the Perl data can run arbitrary Perl code; do it after GC */
+    info.SetSecondPassCallback(bind_data_release);
+}
+
+/* Convert a Perl value for JS, wrapping (instead of copying) any containers. */
+static Local<Value> bind_to_v8(pTHX_ V8Context* ctx, SV* value)
+{
+    if (SvROK(value)) {
+        int type = SvTYPE(SvRV(value));
+        if (type == SVt_PVHV || type == SVt_PVAV) {
+            return pl_bind_wrap(aTHX_ ctx, value);
+        }
+    }
+    return pl_perl_to_v8(aTHX_ value, ctx);
+}
+
+/* Convert a JS value into a brand new Perl value we can store in a container. */
+static SV* bind_to_perl(pTHX_ V8Context* ctx, const Local<Value>& value)
+{
+    SV* tmp = sv_2mortal(pl_v8_to_perl(aTHX_ ctx, Local<Object>::Cast(value)));
+    return newSVsv(tmp);
+}
+
+static void bind_hash_get(pTHX_ const PropertyCallbackInfo<Value>& info, const char* kstr, I32 klen)
+{
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    HV* values = (HV*) SvRV(data->ref);
+    if (SvREADONLY(values) && !hv_exists(values, kstr, -klen)) {
+        return; /* fetching a disallowed key from a locked hash croaks */
+    }
+    SV** found = hv_fetch(values, kstr, -klen, 0);
+    if (!found || !*found) {
+        return; /* not intercepted, look it up in the prototype chain */
+    }
+    info.GetReturnValue().Set(bind_to_v8(aTHX_ data->ctx, *found));
+}
+
+static void bind_hash_put(pTHX_ const PropertyCallbackInfo<Value>& info, const char* kstr, I32 klen, const Local<Value>& value)
+{
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    HV* values = (HV*) SvRV(data->ref);
+    if (SvREADONLY(values)) {
+        /* a locked hash: Perl would croak right through V8 */
+        SV** found = hv_exists(values, kstr, -klen) ? hv_fetch(values, kstr, -klen, 0) : 0;
+        if (!found || !*found || SvREADONLY(*found)) {
+            pl_type_fail_in_js(aTHX_ data->ctx, "Cannot store key %s in locked bound hash\n", kstr);
+            return;
+        }
+    }
+    SV* pvalue = bind_to_perl(aTHX_ data->ctx, value);
+    if (!hv_store(values, kstr, -klen, pvalue, 0)) {
+        SvREFCNT_dec(pvalue);
+        pl_fail_in_js(aTHX_ data->ctx, "Could not store value in bound hash\n");
+        return;
+    }
+    info.GetReturnValue().Set(value);
+}
+
+static void bind_hash_has(pTHX_ const PropertyCallbackInfo<Integer>& info, const char* kstr, I32 klen)
+{
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    HV* values = (HV*) SvRV(data->ref);
+    if (hv_exists(values, kstr, -klen)) {
+        info.GetReturnValue().Set((int32_t) None);
+    }
+}
+
+static void bind_hash_getter(Local<Name> property, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    String::Utf8Value key(info.GetIsolate(), property);
+    bind_hash_get(aTHX_ info, *key, key.length());
+}
+
+static void bind_hash_setter(Local<Name> property, Local<Value> value, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    String::Utf8Value key(info.GetIsolate(), property);
+    bind_hash_put(aTHX_ info, *key, key.length(), value);
+}
+
+static void bind_hash_query(Local<Name> property, const PropertyCallbackInfo<Integer>& info)
+{
+    dTHX;
+    String::Utf8Value key(info.GetIsolate(), property);
+    bind_hash_has(aTHX_ info, *key, key.length());
+}
+
+/* V8 sends integer-like keys (h[1], h["1"]) to the indexed interceptors */
+static void bind_hash_indexed_getter(uint32_t index, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    char key[BIND_KEY_MAX];
+    int klen = sprintf(key, "%u", index);
+    bind_hash_get(aTHX_ info, key, klen);
+}
+
+static void bind_hash_indexed_setter(uint32_t index, Local<Value> value, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    char key[BIND_KEY_MAX];
+    int klen = sprintf(key, "%u", index);
+    bind_hash_put(aTHX_ info, key, klen, value);
+}
+
+static void bind_hash_indexed_query(uint32_t index, const PropertyCallbackInfo<Integer>& info)
+{
+    dTHX;
+    char key[BIND_KEY_MAX];
+    int klen = sprintf(key, "%u", index);
+    bind_hash_has(aTHX_ info, key, klen);
+}
+
+static void bind_hash_enumerator(const PropertyCallbackInfo<Array>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    Isolate* isolate = info.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HV* values = (HV*) SvRV(data->ref);
+    Local<Array> keys = Array::New(isolate);
+    int count = 0;
+    hv_iterinit(values);
+    while (1) {
+        HE* entry = hv_iternext(values);
+        if (!entry) {
+            break; /* no more hash keys */
+        }
+        SV* key = hv_iterkeysv(entry);
+        if (!key) {
+            continue; /* invalid key */
+        }
+        STRLEN klen = 0;
+        const char* kstr = SvPVutf8(key, klen);
+        Local<Value> v8_key = String::NewFromUtf8(isolate, kstr, NewStringType::kNormal, klen).ToLocalChecked();
+        if (!keys->Set(context, count++, v8_key).IsJust()) {
+            pl_fail_in_js(aTHX_ data->ctx, "Could not enumerate keys for bound hash\n");
+            return;
+        }
+    }
+    info.GetReturnValue().Set(keys);
+}
+
+static void bind_array_getter(uint32_t index, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    AV* values = (AV*) SvRV(data->ref);
+    SV** elem = av_fetch(values, index, 0);
+    if (!elem || !*elem) {
+        return;
+    }
+    info.GetReturnValue().Set(bind_to_v8(aTHX_ data->ctx, *elem));
+}
+
+static void bind_array_setter(uint32_t index, Local<Value> value, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    AV* values = (AV*) SvRV(data->ref);
+    if (SvREADONLY(values)) {
+        /* av_store would croak right through V8 */
+        pl_type_fail_in_js(aTHX_ data->ctx, "Cannot store index %u in read-only bound array\n", index);
+        return;
+    }
+    SV* pvalue = bind_to_perl(aTHX_ data->ctx, value);
+    if (!av_store(values, index, pvalue)) {
+        SvREFCNT_dec(pvalue);
+        pl_fail_in_js(aTHX_ data->ctx, "Could not store value in bound array\n");
+        return;
+    }
+    info.GetReturnValue().Set(value);
+}
+
+static void bind_array_query(uint32_t index, const PropertyCallbackInfo<Integer>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    AV* values = (AV*) SvRV(data->ref);
+    if (av_exists(values, index)) {
+        info.GetReturnValue().Set((int32_t) None);
+    }
+}
+
+static void bind_array_enumerator(const PropertyCallbackInfo<Array>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    Isolate* isolate = info.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    AV* values = (AV*) SvRV(data->ref);
+    int array_top = av_top_index(values) + 1;
+    Local<Array> indexes = Array::New(isolate, array_top);
+    for (int j = 0; j < array_top; ++j) {
+        if (!indexes->Set(context, j, Integer::New(isolate, j)).IsJust()) {
+            pl_fail_in_js(aTHX_ data->ctx, "Could not enumerate indexes for bound array\n");
+            return;
+        }
+    }
+    info.GetReturnValue().Set(indexes);
+}
+
+/* The only named property we intercept for arrays is their length. */
+static void bind_array_named_getter(Local<Name> property, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    BindData* data = get_bind_data(info.Holder());
+    if (!data) {
+        return;
+    }
+    String::Utf8Value key(info.GetIsolate(), property);
+    if (strcmp(*key, "length") != 0) {
+        return;
+    }
+    AV* values = (AV*) SvRV(data->ref);
+    info.GetReturnValue().Set((int32_t) (av_top_index(values) + 1));
+}
+
+/* Calls a Perl method, with the wrapped Perl object as the invocant. */
+static void class_method_caller(const FunctionCallbackInfo<Value>& args)
+{
+    Isolate* isolate = args.GetIsolate();
+    HandleScope handle_scope(isolate);
+
+    BindData* data = get_bind_data(args.Holder());
+    if (!data) {
+        return;
+    }
+    Local<External> v8_val = Local<External>::Cast(args.Data());
+    const std::string* method = (const std::string*) v8_val->Value();
+
+    SV* ret = 0;
+    SV *err_tmp;
+
+    /* prepare Perl environment for calling the method */
+    dTHX;
+    dSP;
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+
+    /* pass in the stack the invocant and each of the params we received */
+    XPUSHs(data->ref);
+    int nargs = args.Length();
+    for (int j = 0; j < nargs; j++) {
+        Local<Object> object = Local<Object>::Cast(args[j]);
+        SV* val = pl_v8_to_perl(aTHX_ data->ctx, object);
+        mXPUSHs(val);
+    }
+
+    /* call actual Perl method, passing all params */
+    PUTBACK;
+    double t0 = pl_stats_timer_start(data->ctx);
+    call_method(method->c_str(), G_SCALAR | G_EVAL);
+    pl_stats_timer_stop(data->ctx, PL_STAT_CALLBACK, t0);
+    SPAGAIN;
+
+    /* get returned value from Perl and return it, unless the method died */
+    ret = POPs;
+    err_tmp = ERRSV;
+    if (SvTRUE(err_tmp)) {
+        pl_fail_in_js(aTHX_ data->ctx, "Perl method %s died with error: %s", method->c_str(), SvPV_nolen(err_tmp));
+    }
+    else {
+        Local<Object> object = pl_perl_to_v8(aTHX_ ret, data->ctx);
+        args.GetReturnValue().Set(object);
+    }
+
+    /* cleanup */
+    PUTBACK;
+    FREETMPS;
+    LEAVE;
+}
+
+/* By default we expose all the subs defined in the package, except private
+ * ones (leading underscore) and special ones (all uppercase, like DESTROY). */
+static bool is_public_method(const char* name, I32 len)
+{
+    if (len <= 0 || name[0] == '_') {
+        return false;
+    }
+    for (I32 j = 0; j < len; ++j) {
+        if (isLOWER(name[j])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void get_class_methods(pTHX_ const char* package, AV* methods, std::vector<std::string>& names)
+{
+    if (methods) {
+        int array_top = av_top_index(methods) + 1;
+        for (int j = 0; j < array_top; ++j) {
+            SV** elem = av_fetch(methods, j, 0);
+            if (!elem || !*elem) {
+                continue;
+            }
+            names.push_back(SvPV_nolen(*elem));
+        }
+        return;
+    }
+
+    HV* stash = gv_stashpv(package, 0);
+    if (!stash) {
+        return;
+    }
+    hv_iterinit(stash);
+    while (1) {
+        HE* entry = hv_iternext(stash);
+        if (!entry) {
+            break; /* no more stash entries */
+        }
+        I32 klen = 0;
+        char* kstr = hv_iterkey(entry, &klen);
+        if (!is_public_method(kstr, klen)) {
+            continue;
+        }
+        SV* value = hv_iterval(stash, entry);
+        bool is_sub = false;
+        if (isGV(value)) {
+            is_sub = GvCV((GV*) value) != 0;
+        }
+        else if (SvROK(value)) {
+            /* newer perls store subs directly as coderefs in the stash */
+            is_sub = SvTYPE(SvRV(value)) == SVt_PVCV;
+        }
+        if (is_sub) {
+            names.push_back(std::string(kstr, klen));
+        }
+    }
+}
+
+/* Return the class data for a Perl object, if its package has been registered */
+static ClassData* get_class_data(pTHX_ V8Context* ctx, SV* ref)
+{
+    if (!HvUSEDKEYS(ctx->classes) || !sv_isobject(ref)) {
+        return 0;
+    }
+    const char* package = HvNAME(SvSTASH(SvRV(ref)));
+    if (!package) {
+        return 0;
+    }
+    STRLEN plen = strlen(package);
+    SV** found = hv_fetch(ctx->classes, package, plen, 0);
+    if (!found || !*found) {
+        return 0;
+    }
+
+    ClassKey key(ctx, package);
+    ClassMap::iterator k = class_map.find(key);
+    if (k != class_map.end()) {
+        return k->second;
+    }
+
+    /* first time we see this package in this context, create its template */
+    AV* methods = 0;
+    if (SvROK(*found) && SvTYPE(SvRV(*found)) == SVt_PVAV) {
+        methods = (AV*) SvRV(*found);
+    }
+    ClassData* klass = new ClassData;
+    get_class_methods(aTHX_ package, methods, klass->methods);
+
+    Isolate* isolate = ctx->isolate;
+    Local<FunctionTemplate> ft = FunctionTemplate::New(isolate);
+    ft->SetClassName(String::NewFromUtf8(isolate, package, NewStringType::kNormal).ToLocalChecked());
+    ft->InstanceTemplate()->SetInternalFieldCount(BIND_FIELD_COUNT);
+    Local<Signature> signature = Signature::New(isolate, ft);
+    Local<ObjectTemplate> proto = ft->PrototypeTemplate();
+    for (unsigned int j = 0; j < klass->methods.size(); ++j) {
+        const std::string& method = klass->methods[j];
+        Local<Value> v8_val = External::New(isolate, (void*) &method);
+        Local<FunctionTemplate> mt = FunctionTemplate::New(isolate, class_method_caller, v8_val, signature);
+        proto->Set(String::NewFromUtf8(isolate, method.c_str(), NewStringType::kNormal).ToLocalChecked(), mt);
+    }
+    klass->templ.Reset(isolate, ft);
+    class_map[key] = klass;
+    return klass;
+}
+
+static Local<ObjectTemplate> get_bind_template(V8Context* ctx, int is_array)
+{
+    Persistent<ObjectTemplate>*& persistent = is_array ? ctx->bind_array_template : ctx->bind_hash_template;
+    if (persistent) {
+        return Local<ObjectTemplate>::New(ctx->isolate, *persistent);
+    }
+
+    Local<ObjectTemplate> object_template = ObjectTemplate::New(ctx->isolate);
+    object_template->SetInternalFieldCount(BIND_FIELD_COUNT);
+    if (is_array) {
+        object_template->SetHandler(NamedPropertyHandlerConfiguration(
+                    bind_array_named_getter, 0, 0, 0, 0,
+                    Local<Value>(), PropertyHandlerFlags::kOnlyInterceptStrings));
+        object_template->SetHandler(IndexedPropertyHandlerConfiguration(
+                    bind_array_getter, bind_array_setter, bind_array_query, 0, bind_array_enumerator));
+    } else {
+        object_template->SetHandler(NamedPropertyHandlerConfiguration(
+                    bind_hash_getter, bind_hash_setter, bind_hash_query, 0, bind_hash_enumerator,
+                    Local<Value>(), PropertyHandlerFlags::kOnlyInterceptStrings));
+        object_template->SetHandler(IndexedPropertyHandlerConfiguration(
+                    bind_hash_indexed_getter, bind_hash_indexed_setter, bind_hash_indexed_query));
+    }
+    persistent = new Persistent<ObjectTemplate>(ctx->isolate, object_template);
+    return object_template;
+}
+
+/* Return true if we know how to wrap a Perl value in a JS object */
+static bool can_wrap(pTHX_ V8Context* ctx, SV* ref)
+{
+    SV* container = SvROK(ref) ? SvRV(ref) : 0;
+    int type = container ? SvTYPE(container) : SVt_NULL;
+    return type == SVt_PVHV || type == SVt_PVAV || get_class_data(aTHX_ ctx, ref);
+}
+
+Local<Object> pl_bind_wrap(pTHX_ V8Context* ctx, SV* ref)
+{
+    SV* container = SvROK(ref) ? SvRV(ref) : 0;
+    int type = container ? SvTYPE(container) : SVt_NULL;
+    ClassData* klass = get_class_data(aTHX_ ctx, ref);
+
+    BindKey key(ctx, container);
+    BindMap::iterator k = bind_map.find(key);
+    if (k != bind_map.end()) {
+        return Local<Object>::New(ctx->isolate, k->second->handle);
+    }
+
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    int is_array = !klass && type == SVt_PVAV;
+    Local<Object> object;
+    if (klass) {
+        Local<FunctionTemplate> ft = Local<FunctionTemplate>::New(ctx->isolate, klass->templ);
+        Local<Function> v8_func = ft->GetFunction(context).ToLocalChecked();
+        object = v8_func->NewInstance(context).ToLocalChecked();
+    } else {
+        Local<ObjectTemplate> object_template = get_bind_template(ctx, is_array);
+        object = object_template->NewInstance(context).ToLocalChecked();
+    }
+    if (is_array) {
+        /* Array.prototype methods are generic and work fine on our wrapper */
+        Local<Value> proto = Array::New(ctx->isolate)->GetPrototype();
+        if (!object->SetPrototype(context, proto).FromMaybe(false)) {
+            /* V8Context croaks with this once out of V8; leave it unbound */
+            pl_fail(aTHX_ ctx, "Could not set prototype for bound array\n");
+            return object;
+        }
+    }
+
+    BindData* data = new BindData(ctx, container);
+    object->SetAlignedPointerInInternalField(BIND_FIELD_TAG, &bind_tag);
+    object->SetAlignedPointerInInternalField(BIND_FIELD_DATA, data);
+    data->handle.Reset(ctx->isolate, object);
+    data->handle.SetWeak(data, bind_data_weak, WeakCallbackType::kParameter);
+    bind_map[key] = data;
+
+    return object;
+}
+
+bool pl_bind_is_wrapper(const Local<Value>& value)
+{
+    if (!value->IsObject()) {
+        return false;
+    }
+    return get_bind_data(Local<Object>::Cast(value)) != 0;
+}
+
+bool pl_bind_is_registered_object(pTHX_ V8Context* ctx, SV* ref)
+{
+    return get_class_data(aTHX_ ctx, ref) != 0;
+}
+
+SV* pl_bind_unwrap(pTHX_ V8Context* ctx, const Local<Object>& object)
+{
+    if (!object->IsObject()) {
+        return 0;
+    }
+    BindData* data = get_bind_data(object);
+    if (!data) {
+        return 0;
+    }
+    return newRV_inc(SvRV(data->ref));
+}
+
+static void bind_scalar_getter(Local<Name> property, const PropertyCallbackInfo<Value>& info)
+{
+    dTHX;
+    Local<External> v8_val = Local<External>::Cast(info.Data());
+    ScalarData* data = (ScalarData*) v8_val->Value();
+    info.GetReturnValue().Set(pl_perl_to_v8(aTHX_ SvRV(data->ref), data->ctx));
+}
+
+static void bind_scalar_setter(Local<Name> property, Local<Value> value, const PropertyCallbackInfo<void>& info)
+{
+    dTHX;
+    Local<External> v8_val = Local<External>::Cast(info.Data());
+    ScalarData* data = (ScalarData*) v8_val->Value();
+    SV* target = SvRV(data->ref);
+    if (SvREADONLY(target)) {
+        /* sv_setsv_mg would croak right through V8 */
+        String::Utf8Value name(info.GetIsolate(), property);
+        pl_type_fail_in_js(aTHX_ data->ctx, "Cannot assign to read-only bound scalar %s\n", *name);
+        return;
+    }
+    SV* pvalue = sv_2mortal(pl_v8_to_perl(aTHX_ data->ctx, Local<Object>::Cast(value)));
+    sv_setsv_mg(target, pvalue);
+}
+
+static bool is_dotted_name(const std::string& name)
+{
+    return name.find('.') != std::string::npos;
+}
+
+static bool install_scalar_accessor(V8Context* ctx, Local<Context>& context, const std::string& name, ScalarData* data)
+{
+    Local<Object> parent;
+    Local<Value> slot;
+    TryCatch try_catch(ctx->isolate);
+    if (!find_parent(ctx, name.c_str(), context, parent, slot, true)) {
+        return false;
+    }
+    Local<Value> v8_val = External::New(ctx->isolate, data);
+    Local<Name> v8_name = Local<Name>::Cast(slot);
+    return parent->SetAccessor(context, v8_name, bind_scalar_getter, bind_scalar_setter, v8_val).FromMaybe(false);
+}
+
+int pl_bind_scalar_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* ref)
+{
+    if (!SvROK(ref) || SvTYPE(SvRV(ref)) >= SVt_PVAV) {
+        /* V8Context croaks with this once out of V8 */
+        pl_fail(aTHX_ ctx, "Can only bind a scalar reference\n");
+        return 0;
+    }
+
+    ScalarKey key(ctx, name);
+    ScalarMap::iterator k = scalar_map.find(key);
+    ScalarData* data = 0;
+    if (k != scalar_map.end()) {
+        /* rebinding: any accessors already installed will use the new scalar */
+        data = k->second;
+        SvREFCNT_dec(data->ref);
+        data->ref = newSVsv(ref);
+        return 1;
+    }
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    /* only keep the binding if it could be installed, or every reset would fail */
+    data = new ScalarData(ctx, ref);
+    if (!install_scalar_accessor(ctx, context, name, data)) {
+        SvREFCNT_dec(data->ref);
+        delete data;
+        pl_fail(aTHX_ ctx, "Could not bind scalar to %s\n", name);
+        return 0;
+    }
+    scalar_map[key] = data;
+    return 1;
+}
+
+int pl_bind_scalars_on_template(V8Context* ctx, Local<ObjectTemplate>& object_template)
+{
+    int count = 0;
+    ScalarMap::iterator k = scalar_map.lower_bound(ScalarKey(ctx, std::string()));
+    for (; k != scalar_map.end() && k->first.first == ctx; ++k) {
+        const std::string& name = k->first.second;
+        if (is_dotted_name(name)) {
+            continue;
+        }
+        Local<Value> v8_val = External::New(ctx->isolate, k->second);
+        Local<Name> v8_name = String::NewFromUtf8(ctx->isolate, name.c_str(), NewStringType::kNormal).ToLocalChecked();
+        object_template->SetAccessor(v8_name, bind_scalar_getter, bind_scalar_setter, v8_val);
+        ++count;
+    }
+    return count;
+}
+
+int pl_bind_scalars_on_context(V8Context* ctx)
+{
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    int count = 0;
+    ScalarMap::iterator k = scalar_map.lower_bound(ScalarKey(ctx, std::string()));
+    for (; k != scalar_map.end() && k->first.first == ctx; ++k) {
+        const std::string& name = k->first.second;
+        if (!is_dotted_name(name)) {
+            continue;
+        }
+        /* the parent may have become something else; skip it, do not fail a reset */
+        if (install_scalar_accessor(ctx, context, name, k->second)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int pl_bind_register_class(pTHX_ V8Context* ctx, const char* package, AV* methods)
+{
+    STRLEN plen = strlen(package);
+    SV* pvalue = methods ? newRV_inc((SV*) methods) : newSV(0);
+    if (!hv_store(ctx->classes, package, plen, pvalue, 0)) {
+        SvREFCNT_dec(pvalue);
+        croak("Could not register class %s\n", package);
+    }
+    return 1;
+}
+
+int pl_bind_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* ref)
+{
+    if (!can_wrap(aTHX_ ctx, ref)) {
+        /* V8Context croaks with this once out of V8 */
+        pl_fail(aTHX_ ctx, "Can only bind a hashref, an arrayref or an object from a registered class\n");
+        return 0;
+    }
+
+    int ret = 0;
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    Local<Object> parent;
+    Local<Value> slot;
+    bool found = find_parent(ctx, name, context, parent, slot);
+    if (found) {
+        Local<Object> object = pl_bind_wrap(aTHX_ ctx, ref);
+        TryCatch try_catch(ctx->isolate);
+        if (!parent->Set(context, slot, object).FromMaybe(false)) {
+            /* V8Context croaks with this once out of V8 */
+            pl_fail(aTHX_ ctx, "Could not bind global or property %s\n", name);
+            return 0;
+        }
+        ret = 1;
+    }
+
+    return ret;
+}
+
+void pl_bind_tear_down(pTHX_ V8Context* ctx)
+{
+    BindMap::iterator k = bind_map.lower_bound(BindKey(ctx, 0));
+    while (k != bind_map.end() && k->first.first == ctx) {
+        BindData* data = k->second;
+        data->handle.Reset();
+        SvREFCNT_dec(data->ref);
+        delete data;
+        bind_map.erase(k++);
+    }
+
+    ClassMap::iterator c = class_map.lower_bound(ClassKey(ctx, std::string()));
+    while (c != class_map.end() && c->first.first == ctx) {
+        ClassData* klass = c->second;
+        klass->templ.Reset();
+        delete klass;
+        class_map.erase(c++);
+    }
+
+    delete ctx->bind_hash_template;
+    delete ctx->bind_array_template;
+    ctx->bind_hash_template = 0;
+    ctx->bind_array_template = 0;
+}
+
+void pl_bind_destroy(pTHX_ V8Context* ctx)
+{
+    ScalarMap::iterator k = scalar_map.lower_bound(ScalarKey(ctx, std::string()));
+    while (k != scalar_map.end() && k->first.first == ctx) {
+        ScalarData* data = k->second;
+        SvREFCNT_dec(data->ref);
+        delete data;
+        scalar_map.erase(k++);
+    }
+}
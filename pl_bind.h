@@ -0,0 +1,75 @@
+#ifndef PL_BIND_H
+#define PL_BIND_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Instead of deep-copying Perl data into the JS heap (which is what
+ * pl_perl_to_v8 does), we can expose a Perl hash or array to JS through an
+ * ObjectTemplate with named and indexed property interceptors.  Each access
+ * from JS looks up the underlying HV / AV on demand, so only the leaves that
+ * are actually touched are converted.  Nested hashes / arrays are wrapped
+ * lazily, when they are first accessed.
+ *
+ * pl_bind_wrap: takes a Perl hashref / arrayref (or an object from a
+ * registered class) and returns a JS object that wraps it; callers must only
+ * pass values of those types.
+ *
+ * pl_bind_is_wrapper: return true if a JS value is a wrapper for Perl data.
+ *
+ * pl_bind_unwrap: if a JS object is a wrapper for Perl data, return a new
+ * reference to that data; otherwise return 0.
+ */
+Local<Object> pl_bind_wrap(pTHX_ V8Context* ctx, SV* ref);
+bool pl_bind_is_wrapper(const Local<Value>& value);
+SV* pl_bind_unwrap(pTHX_ V8Context* ctx, const Local<Object>& object);
+
+/*
+ * Register a Perl package, so that its instances are passed to JS as objects
+ * whose methods dispatch to the Perl methods, instead of being flattened into
+ * plain data.  The Perl object is kept in an internal field of the JS object,
+ * and the prototype (built once per package from a cached FunctionTemplate)
+ * has one function per method.  If methods is null, all public subs in the
+ * package are exposed.
+ *
+ * pl_bind_is_registered_object: return true if a Perl value is an object from
+ * a registered package.
+ */
+int pl_bind_register_class(pTHX_ V8Context* ctx, const char* package, AV* methods);
+bool pl_bind_is_registered_object(pTHX_ V8Context* ctx, SV* ref);
+
+/*
+ * Set a global / nested property to a wrapper for Perl data.
+ */
+int pl_bind_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* ref);
+
+/*
+ * Bind a Perl scalar to a global / nested property, using a native accessor:
+ * reads and writes from JS go straight to the Perl scalar, so changing the
+ * value from Perl is just a plain assignment.
+ *
+ * These bindings survive a reset: pl_bind_scalars_on_template installs the
+ * accessors for global names in the template for the global object, before
+ * creating a context; pl_bind_scalars_on_context installs the ones for nested
+ * names, after creating a context.
+ */
+int pl_bind_scalar_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* ref);
+int pl_bind_scalars_on_template(V8Context* ctx, Local<ObjectTemplate>& object_template);
+int pl_bind_scalars_on_context(V8Context* ctx);
+
+/*
+ * Release all wrappers and templates created for a context.
+ */
+void pl_bind_tear_down(pTHX_ V8Context* ctx);
+
+/*
+ * Release all bindings registered for a context, when it is destroyed.
+ */
+void pl_bind_destroy(pTHX_ V8Context* ctx);
+
+#endif
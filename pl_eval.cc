@@ -3,6 +3,8 @@
 #include "pl_console.h"
 #include "pl_eventloop.h"
 #include "pl_v8.h"
+#include "pl_sandbox.h"
+#include "pl_watchdog.h"
 #include "ppport.h"
 
 #define PL_GC_RUNS 2
@@ -16,6 +18,20 @@ static const char* ToCString(const String::Utf8Value& value)
 
 static void ReportException(pTHX_ V8Context* ctx, TryCatch* try_catch)
 {
+    if (try_catch->HasTerminated()) {
+        /* we asked V8 to stop running this code, there is no real exception */
+        if (ctx->watchdog_depth) {
+            /* nested inside other JS code, which must be terminated as well */
+            return;
+        }
+        pl_sandbox_report_termination(ctx);
+        return;
+    }
+    if (ctx->pending_error) {
+        /* this was thrown because Perl code failed; we croak with that error */
+        return;
+    }
+
     SV* buffer = newSVpvs("");
 
     Isolate* isolate = ctx->isolate;
@@ -76,7 +92,7 @@ static void ReportException(pTHX_ V8Context* ctx, TryCatch* try_catch)
     pl_show_error(ctx, "%s", bstr);
 }
 
-SV* pl_eval(pTHX_ V8Context* ctx, const char* code, const char* file)
+SV* pl_eval(pTHX_ V8Context* ctx, const char* code, const char* file, bool convert)
 {
     SV* ret = &PL_sv_undef; /* return undef by default */
 
@@ -112,26 +128,34 @@ SV* pl_eval(pTHX_ V8Context* ctx, const char* code, const char* file)
         Perf perf;
 
         /* Compile the source code. */
-        pl_stats_start(aTHX_ ctx, &perf);
+        pl_watchdog_arm(ctx);
+        pl_stats_start(aTHX_ ctx, &perf, PL_STAT_COMPILE);
         Local<Script> script;
         ok = Script::Compile(context, source, origin).ToLocal(&script);
-        pl_stats_stop(aTHX_ ctx, &perf, "compile");
+        pl_stats_stop(aTHX_ ctx, &perf);
         if (!ok) {
+            pl_watchdog_disarm(ctx);
             break;
         }
 
         /* Run the script to get the result. */
-        pl_stats_start(aTHX_ ctx, &perf);
+        pl_stats_start(aTHX_ ctx, &perf, PL_STAT_RUN);
         Local<Value> result;
         ok = script->Run(context).ToLocal(&result);
-        pl_stats_stop(aTHX_ ctx, &perf, "run");
+        pl_stats_stop(aTHX_ ctx, &perf);
+        pl_watchdog_disarm(ctx);
         if (!ok) {
             break;
         }
+        if (ctx->terminate_reason != PL_TERMINATE_NONE && !ctx->watchdog_depth) {
+            pl_sandbox_cancel_termination(ctx);
+        }
 
-        /* Convert the result into Perl data */
-        Local<Object> object = Local<Object>::Cast(result);
-        ret = pl_v8_to_perl(aTHX_ ctx, object);
+        /* Convert the result into Perl data, unless caller doesn't want it */
+        if (convert) {
+            Local<Object> object = Local<Object>::Cast(result);
+            ret = pl_v8_to_perl(aTHX_ ctx, object);
+        }
 
         /* Launch eventloop; call only returns after eventloop terminates. */
         eventloop_run(ctx);
@@ -164,10 +188,15 @@ int pl_run_function(V8Context* ctx, Persistent<Function>& func)
         Local<Value> global = context->Global();
         Local<Function> v8_func = Local<Function>::New(ctx->isolate, func);
 
+        pl_watchdog_arm(ctx);
         ok = v8_func->Call(context, global, 0, 0).ToLocal(&result);
+        pl_watchdog_disarm(ctx);
         if (!ok) {
             break;
         }
+        if (ctx->terminate_reason != PL_TERMINATE_NONE && !ctx->watchdog_depth) {
+            pl_sandbox_cancel_termination(ctx);
+        }
     } while (0);
     if (!ok) {
         if (try_catch.HasCaught()) {
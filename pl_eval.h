@@ -8,7 +8,12 @@
 using namespace v8;
 class V8Context;
 
-SV* pl_eval(pTHX_ V8Context* ctx, const char* code, const char* file = 0);
+/*
+ * Compile and run a piece of JS code, then run the eventloop.  The completion
+ * value is converted into Perl data only when convert is true; otherwise
+ * undef is returned.
+ */
+SV* pl_eval(pTHX_ V8Context* ctx, const char* code, const char* file = 0, bool convert = true);
 int pl_run_function(V8Context* ctx, Persistent<Function>& func);
 
 #endif
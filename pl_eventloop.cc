@@ -217,6 +217,10 @@ int eventloop_run(V8Context* ctx) {
     return 0;
 }
 
+int eventloop_pending_timers(void) {
+    return timer_count;
+}
+
 static void create_timer(const FunctionCallbackInfo<Value>& args)
 {
     Local<External> v8_val = Local<External>::Cast(args.Data());
@@ -387,7 +391,7 @@ SV* pl_run_function_in_event_loop(pTHX_ V8Context* ctx, const char* func)
     /* TODO: stop using a fixed size buffer */
     char js[1024];
     sprintf(js, "setTimeout(function() { %s(); }, 0);", func);
-    pl_eval(aTHX_ ctx, js);
+    pl_eval(aTHX_ ctx, js, 0, false);
 
     /* Launch eventloop; this call only returns after the eventloop terminates. */
     eventloop_run(ctx);
@@ -5,6 +5,7 @@
 #include "ppport.h"
 
 int eventloop_run(V8Context* ctx);
+int eventloop_pending_timers(void);
 
 int pl_register_eventloop_functions(V8Context* ctx);
 SV* pl_run_function_in_event_loop(pTHX_ V8Context* ctx, const char* func);
@@ -0,0 +1,122 @@
+#include "pl_util.h"
+#include "pl_stats.h"
+#include "pl_heap.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+#define HEAP_STAT(hv, stats, name) \
+    hv_stores(hv, #name, newSVnv((double) stats.name()))
+
+static size_t used_heap_size(Isolate* isolate)
+{
+    HeapStatistics hs;
+    isolate->GetHeapStatistics(&hs);
+    return hs.used_heap_size();
+}
+
+static PlStat gc_stat(GCType type)
+{
+    switch (type) {
+        case kGCTypeScavenge:
+            return PL_STAT_GC_SCAVENGE;
+        case kGCTypeIncrementalMarking:
+            return PL_STAT_GC_INCREMENTAL;
+        case kGCTypeProcessWeakCallbacks:
+            return PL_STAT_GC_WEAK_CALLBACKS;
+        default:
+            /* full GC, or a newer type we don't know about */
+            return PL_STAT_GC_MARK_COMPACT;
+    }
+}
+
+static void gc_prologue(Isolate* isolate, GCType type, GCCallbackFlags flags, void* data)
+{
+    V8Context* ctx = (V8Context*) data;
+    ctx->heap_used_before_gc = used_heap_size(isolate);
+    ctx->gc_started_us = monotonic_us();
+}
+
+static void gc_epilogue(Isolate* isolate, GCType type, GCCallbackFlags flags, void* data)
+{
+    V8Context* ctx = (V8Context*) data;
+    size_t used = used_heap_size(isolate);
+    if (used < ctx->heap_used_before_gc) {
+        ctx->heap_freed_bytes += ctx->heap_used_before_gc - used;
+    }
+    pl_stats_record_gc(ctx, gc_stat(type), monotonic_us() - ctx->gc_started_us);
+}
+
+void pl_heap_set_up(V8Context* ctx)
+{
+    ctx->heap_used_before_gc = 0;
+    ctx->heap_freed_bytes = 0;
+    if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
+        return;
+    }
+    ctx->isolate->AddGCPrologueCallback(gc_prologue, ctx);
+    ctx->isolate->AddGCEpilogueCallback(gc_epilogue, ctx);
+}
+
+void pl_heap_tear_down(V8Context* ctx)
+{
+    if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
+        return;
+    }
+    ctx->isolate->RemoveGCPrologueCallback(gc_prologue, ctx);
+    ctx->isolate->RemoveGCEpilogueCallback(gc_epilogue, ctx);
+}
+
+double pl_heap_allocated_bytes(V8Context* ctx)
+{
+    return (double) used_heap_size(ctx->isolate) + ctx->heap_freed_bytes;
+}
+
+SV* pl_heap_get_stats(pTHX_ V8Context* ctx)
+{
+    HV* ret = newHV();
+
+    HeapStatistics hs;
+    ctx->isolate->GetHeapStatistics(&hs);
+    HV* heap = newHV();
+    HEAP_STAT(heap, hs, total_heap_size);
+    HEAP_STAT(heap, hs, total_heap_size_executable);
+    HEAP_STAT(heap, hs, total_physical_size);
+    HEAP_STAT(heap, hs, total_available_size);
+    HEAP_STAT(heap, hs, used_heap_size);
+    HEAP_STAT(heap, hs, heap_size_limit);
+    HEAP_STAT(heap, hs, malloced_memory);
+    HEAP_STAT(heap, hs, peak_malloced_memory);
+    HEAP_STAT(heap, hs, number_of_native_contexts);
+    HEAP_STAT(heap, hs, number_of_detached_contexts);
+    hv_stores(ret, "heap", newRV_noinc((SV*) heap));
+
+    HV* spaces = newHV();
+    size_t num_spaces = ctx->isolate->NumberOfHeapSpaces();
+    for (size_t j = 0; j < num_spaces; ++j) {
+        HeapSpaceStatistics ss;
+        if (!ctx->isolate->GetHeapSpaceStatistics(&ss, j)) {
+            continue;
+        }
+        HV* space = newHV();
+        HEAP_STAT(space, ss, space_size);
+        HEAP_STAT(space, ss, space_used_size);
+        HEAP_STAT(space, ss, space_available_size);
+        HEAP_STAT(space, ss, physical_space_size);
+        hv_store(spaces, ss.space_name(), strlen(ss.space_name()), newRV_noinc((SV*) space), 0);
+    }
+    hv_stores(ret, "spaces", newRV_noinc((SV*) spaces));
+
+    HeapCodeStatistics cs;
+    if (ctx->isolate->GetHeapCodeAndMetadataStatistics(&cs)) {
+        HV* code = newHV();
+        HEAP_STAT(code, cs, code_and_metadata_size);
+        HEAP_STAT(code, cs, bytecode_and_metadata_size);
+        hv_stores(ret, "code", newRV_noinc((SV*) code));
+    }
+
+    /* adjusting by zero just returns the current amount */
+    int64_t external = ctx->isolate->AdjustAmountOfExternalAllocatedMemory(0);
+    hv_stores(ret, "external_memory", newSVnv((double) external));
+
+    return newRV_noinc((SV*) ret);
+}
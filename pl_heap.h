@@ -0,0 +1,33 @@
+#ifndef PL_HEAP_H
+#define PL_HEAP_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Keep track of how many bytes the JS code has allocated in the V8 heap.
+ *
+ * The size of the used heap goes down every time the GC runs, so we register
+ * GC callbacks that add up the bytes freed by each GC; the used heap size plus
+ * the bytes freed so far is then a counter that never goes down, and the
+ * difference between two readings of it is the number of bytes allocated in
+ * between.
+ *
+ * The same callbacks time each GC and record it in the stats, by type, and
+ * charged to the operation that was running when it happened.
+ */
+void pl_heap_set_up(V8Context* ctx);
+void pl_heap_tear_down(V8Context* ctx);
+double pl_heap_allocated_bytes(V8Context* ctx);
+
+/*
+ * Return a hashref with all the heap statistics from V8: for the heap as a
+ * whole, for each heap space, for code, and the external memory.
+ */
+SV* pl_heap_get_stats(pTHX_ V8Context* ctx);
+
+#endif
@@ -137,6 +137,6 @@ void pl_register_inlined_functions(V8Context* ctx)
     size_t j = 0;
     dTHX;
     for (j = 0; j < sizeof(js_inlined) / sizeof(js_inlined[0]); ++j) {
-        pl_eval(aTHX_ ctx, js_inlined[j].source, js_inlined[j].file_name);
+        pl_eval(aTHX_ ctx, js_inlined[j].source, js_inlined[j].file_name, false);
     }
 }
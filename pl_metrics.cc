@@ -0,0 +1,301 @@
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <stdio.h>
+#include <string.h>
+#include <v8.h>
+#include "pl_eventloop.h"
+#include "pl_monitor.h"
+#include "pl_metrics.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+#define METRICS_PREFIX "v8xs_"
+
+/*
+ * Buckets for the exported histograms, as powers of two in microseconds:
+ * 1 us, 4 us, 16 us, ... up to 2^26 us (about 67 s); anything larger only
+ * goes into the implicit +Inf bucket.
+ */
+#define METRICS_BUCKET_STEP 2
+#define METRICS_BUCKETS     14
+
+struct MetricsStat {
+    std::atomic<unsigned long> calls;
+    std::atomic<unsigned long> count;
+    std::atomic<unsigned long long> sum_ns;
+    std::atomic<unsigned long> buckets[METRICS_BUCKETS + 1];  /* last one is +Inf */
+};
+
+static MetricsStat metrics_stats[PL_STAT_COUNT];
+
+static const char* recycle_reasons[] = { "evals", "seconds", "heap_bytes" };
+#define RECYCLE_REASONS (sizeof(recycle_reasons) / sizeof(recycle_reasons[0]))
+static std::atomic<unsigned long> recycles[RECYCLE_REASONS];
+
+static std::atomic<unsigned long long> cgroup_current;
+static std::atomic<unsigned long long> cgroup_max;
+static std::atomic<unsigned long> pressure_events[PL_MONITOR_LEVELS];
+
+/* Allocated once and never released, like the watchdog state */
+static std::mutex* live_mutex = new std::mutex;
+static std::set<V8Context*>* live_contexts = new std::set<V8Context*>;
+
+void pl_metrics_register(V8Context* ctx)
+{
+    std::lock_guard<std::mutex> lock(*live_mutex);
+    live_contexts->insert(ctx);
+}
+
+void pl_metrics_unregister(V8Context* ctx)
+{
+    std::lock_guard<std::mutex> lock(*live_mutex);
+    live_contexts->erase(ctx);
+}
+
+void pl_metrics_for_each_context(void (*func)(V8Context* ctx, void* data), void* data)
+{
+    std::lock_guard<std::mutex> lock(*live_mutex);
+    std::set<V8Context*>::const_iterator k;
+    for (k = live_contexts->begin(); k != live_contexts->end(); ++k) {
+        func(*k, data);
+    }
+}
+
+void pl_metrics_call(PlStat stat)
+{
+    metrics_stats[stat].calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void pl_metrics_observe(PlStat stat, double elapsed_us)
+{
+    MetricsStat* metric = &metrics_stats[stat];
+    int bucket = 0;
+    for (double limit = 1.0; bucket < METRICS_BUCKETS; ++bucket, limit *= 1 << METRICS_BUCKET_STEP) {
+        if (elapsed_us <= limit) {
+            break;
+        }
+    }
+    metric->count.fetch_add(1, std::memory_order_relaxed);
+    metric->sum_ns.fetch_add((unsigned long long) (elapsed_us * 1000.0), std::memory_order_relaxed);
+    metric->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void pl_metrics_recycle(const char* reason)
+{
+    for (unsigned int j = 0; j < RECYCLE_REASONS; ++j) {
+        if (strcmp(reason, recycle_reasons[j]) == 0) {
+            recycles[j].fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+void pl_metrics_cgroup_memory(double current, double max)
+{
+    cgroup_current.store((unsigned long long) current, std::memory_order_relaxed);
+    cgroup_max.store((unsigned long long) max, std::memory_order_relaxed);
+}
+
+void pl_metrics_memory_pressure(int level)
+{
+    pressure_events[level].fetch_add(1, std::memory_order_relaxed);
+}
+
+static void add_header(std::string& text, const char* name, const char* type, const char* unit, const char* help)
+{
+    text += "# TYPE " METRICS_PREFIX;
+    text += name;
+    text += " ";
+    text += type;
+    text += "\n";
+    if (unit) {
+        text += "# UNIT " METRICS_PREFIX;
+        text += name;
+        text += " ";
+        text += unit;
+        text += "\n";
+    }
+    text += "# HELP " METRICS_PREFIX;
+    text += name;
+    text += " ";
+    text += help;
+    text += "\n";
+}
+
+static void add_sample(std::string& text, const char* name, const char* suffix, const char* labels, double value)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), " %.17g\n", value);
+    text += METRICS_PREFIX;
+    text += name;
+    text += suffix;
+    if (labels && labels[0]) {
+        text += "{";
+        text += labels;
+        text += "}";
+    }
+    text += buf;
+}
+
+static void add_operations(std::string& text)
+{
+    char labels[128];
+
+    add_header(text, "operation_calls", "counter", 0,
+               "Number of calls to each operation, for contexts gathering stats.");
+    for (int j = 0; j < PL_STAT_COUNT; ++j) {
+        unsigned long calls = metrics_stats[j].calls.load(std::memory_order_relaxed);
+        if (!calls) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "op=\"%s\"", pl_stats_name((PlStat) j));
+        add_sample(text, "operation_calls", "_total", labels, calls);
+    }
+
+    add_header(text, "operation_seconds", "histogram", "seconds",
+               "Time taken by each measured operation, for contexts gathering stats.");
+    for (int j = 0; j < PL_STAT_COUNT; ++j) {
+        const MetricsStat* metric = &metrics_stats[j];
+        unsigned long count = metric->count.load(std::memory_order_relaxed);
+        if (!count) {
+            continue;
+        }
+        const char* name = pl_stats_name((PlStat) j);
+        unsigned long cumulative = 0;
+        double limit = 1.0;
+        for (int k = 0; k < METRICS_BUCKETS; ++k, limit *= 1 << METRICS_BUCKET_STEP) {
+            cumulative += metric->buckets[k].load(std::memory_order_relaxed);
+            snprintf(labels, sizeof(labels), "op=\"%s\",le=\"%g\"", name, limit / 1e6);
+            add_sample(text, "operation_seconds", "_bucket", labels, cumulative);
+        }
+        /* the count is read separately, so make sure the buckets are consistent with it */
+        cumulative += metric->buckets[METRICS_BUCKETS].load(std::memory_order_relaxed);
+        snprintf(labels, sizeof(labels), "op=\"%s\",le=\"+Inf\"", name);
+        add_sample(text, "operation_seconds", "_bucket", labels, cumulative);
+        snprintf(labels, sizeof(labels), "op=\"%s\"", name);
+        add_sample(text, "operation_seconds", "_count", labels, cumulative);
+        add_sample(text, "operation_seconds", "_sum", labels,
+                   metric->sum_ns.load(std::memory_order_relaxed) / 1e9);
+    }
+}
+
+static void add_recycles(std::string& text)
+{
+    char labels[128];
+
+    add_header(text, "recycles", "counter", 0,
+               "Number of times an isolate was recycled, by reason.");
+    for (unsigned int j = 0; j < RECYCLE_REASONS; ++j) {
+        snprintf(labels, sizeof(labels), "reason=\"%s\"", recycle_reasons[j]);
+        add_sample(text, "recycles", "_total", labels, recycles[j].load(std::memory_order_relaxed));
+    }
+}
+
+struct HeapTotals {
+    HeapTotals() : contexts(0), used(0), total(0), limit(0), external(0) {}
+
+    long contexts;
+    double used;
+    double total;
+    double limit;
+    double external;
+    std::map<std::string, std::pair<double, double>> spaces;  /* size, used */
+};
+
+static void add_heap_totals(V8Context* ctx, void* data)
+{
+    HeapTotals* totals = (HeapTotals*) data;
+    Isolate* isolate = ctx->isolate;
+    HeapStatistics hs;
+    isolate->GetHeapStatistics(&hs);
+    ++totals->contexts;
+    totals->used += hs.used_heap_size();
+    totals->total += hs.total_heap_size();
+    totals->limit += hs.heap_size_limit();
+    /* adjusting by zero just returns the current amount */
+    totals->external += isolate->AdjustAmountOfExternalAllocatedMemory(0);
+
+    size_t num_spaces = isolate->NumberOfHeapSpaces();
+    for (size_t j = 0; j < num_spaces; ++j) {
+        HeapSpaceStatistics ss;
+        if (!isolate->GetHeapSpaceStatistics(&ss, j)) {
+            continue;
+        }
+        std::pair<double, double>& space = totals->spaces[ss.space_name()];
+        space.first += ss.space_size();
+        space.second += ss.space_used_size();
+    }
+}
+
+static void add_heap(std::string& text)
+{
+    HeapTotals totals;
+    pl_metrics_for_each_context(add_heap_totals, &totals);
+    double used = totals.used;
+    double total = totals.total;
+    double limit = totals.limit;
+    double external = totals.external;
+    const std::map<std::string, std::pair<double, double>>& spaces = totals.spaces;
+
+    add_header(text, "contexts", "gauge", 0, "Number of live contexts.");
+    add_sample(text, "contexts", "", 0, totals.contexts);
+
+    add_header(text, "heap_used_bytes", "gauge", "bytes", "Used size of the V8 heaps of all live contexts.");
+    add_sample(text, "heap_used_bytes", "", 0, used);
+    add_header(text, "heap_total_bytes", "gauge", "bytes", "Total size of the V8 heaps of all live contexts.");
+    add_sample(text, "heap_total_bytes", "", 0, total);
+    add_header(text, "heap_limit_bytes", "gauge", "bytes", "Size limit of the V8 heaps of all live contexts.");
+    add_sample(text, "heap_limit_bytes", "", 0, limit);
+    add_header(text, "heap_external_bytes", "gauge", "bytes", "Memory kept alive by JS objects outside the V8 heaps.");
+    add_sample(text, "heap_external_bytes", "", 0, external);
+
+    char labels[128];
+    std::map<std::string, std::pair<double, double>>::const_iterator s;
+    add_header(text, "heap_space_size_bytes", "gauge", "bytes", "Size of each V8 heap space, for all live contexts.");
+    for (s = spaces.begin(); s != spaces.end(); ++s) {
+        snprintf(labels, sizeof(labels), "space=\"%s\"", s->first.c_str());
+        add_sample(text, "heap_space_size_bytes", "", labels, s->second.first);
+    }
+    add_header(text, "heap_space_used_bytes", "gauge", "bytes", "Used size of each V8 heap space, for all live contexts.");
+    for (s = spaces.begin(); s != spaces.end(); ++s) {
+        snprintf(labels, sizeof(labels), "space=\"%s\"", s->first.c_str());
+        add_sample(text, "heap_space_used_bytes", "", labels, s->second.second);
+    }
+}
+
+static void add_monitor(std::string& text)
+{
+    char labels[128];
+
+    add_header(text, "cgroup_memory_current_bytes", "gauge", "bytes",
+               "Memory used by the cgroup of this process, as last seen by the memory monitor.");
+    add_sample(text, "cgroup_memory_current_bytes", "", 0, cgroup_current.load(std::memory_order_relaxed));
+    add_header(text, "cgroup_memory_max_bytes", "gauge", "bytes",
+               "Memory limit for the cgroup of this process, as last seen by the memory monitor.");
+    add_sample(text, "cgroup_memory_max_bytes", "", 0, cgroup_max.load(std::memory_order_relaxed));
+
+    add_header(text, "memory_pressure_events", "counter", 0,
+               "Number of times the memory monitor changed the memory pressure level, by level.");
+    for (int j = 0; j < PL_MONITOR_LEVELS; ++j) {
+        snprintf(labels, sizeof(labels), "level=\"%s\"", pl_monitor_level_name(j));
+        add_sample(text, "memory_pressure_events", "_total", labels, pressure_events[j].load(std::memory_order_relaxed));
+    }
+}
+
+SV* pl_metrics_text(pTHX)
+{
+    std::string text;
+    add_operations(text);
+    add_recycles(text);
+    add_heap(text);
+    add_monitor(text);
+
+    add_header(text, "timers_pending", "gauge", 0, "Number of pending JS timers.");
+    add_sample(text, "timers_pending", "", 0, eventloop_pending_timers());
+
+    text += "# EOF\n";
+    return newSVpvn(text.c_str(), text.length());
+}
@@ -0,0 +1,40 @@
+#ifndef PL_METRICS_H
+#define PL_METRICS_H
+
+#include "pl_stats.h"
+#include "ppport.h"
+
+class V8Context;
+
+/*
+ * Process-wide metrics, aggregated across all V8Context instances.
+ *
+ * Every measurement recorded by pl_stats for a context (with gather_stats
+ * on) is also added to a set of process-wide atomic counters; these are
+ * cheap to update and can be rendered at any time, without walking the stats
+ * for each context.
+ *
+ * We also keep a registry of all contexts with a live isolate, so that we can
+ * report on their heaps; a context is registered right after creating its
+ * isolate and unregistered right before disposing it.  The registry is
+ * protected by a mutex, so pl_metrics_for_each_context can be used from other
+ * threads, and the isolates will not go away while it runs.
+ */
+void pl_metrics_register(V8Context* ctx);
+void pl_metrics_unregister(V8Context* ctx);
+void pl_metrics_for_each_context(void (*func)(V8Context* ctx, void* data), void* data);
+
+void pl_metrics_call(PlStat stat);
+void pl_metrics_observe(PlStat stat, double elapsed_us);
+void pl_metrics_recycle(const char* reason);
+
+/* Called by the memory monitor, from its own thread */
+void pl_metrics_cgroup_memory(double current, double max);
+void pl_metrics_memory_pressure(int level);
+
+/*
+ * Render all process-wide metrics in the OpenMetrics text exposition format.
+ */
+SV* pl_metrics_text(pTHX);
+
+#endif
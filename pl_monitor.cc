@@ -0,0 +1,316 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+#include <v8.h>
+#include "pl_metrics.h"
+#include "pl_stats.h"
+#include "pl_monitor.h"
+#include "V8Context.h"
+
+#define MONITOR_OPT_NAME_INTERVAL_MS  "interval_ms"
+#define MONITOR_OPT_NAME_MODERATE     "moderate"
+#define MONITOR_OPT_NAME_CRITICAL     "critical"
+#define MONITOR_OPT_NAME_CURRENT_FILE "current_file"
+#define MONITOR_OPT_NAME_MAX_FILE     "max_file"
+
+#define MONITOR_DEFAULT_INTERVAL_MS   1000
+#define MONITOR_MINIMUM_INTERVAL_MS   10
+#define MONITOR_DEFAULT_MODERATE      0.80
+#define MONITOR_DEFAULT_CRITICAL      0.95
+
+#define CGROUP_ROOT                   "/sys/fs/cgroup"
+#define CGROUP_V1_MEMORY_ROOT         CGROUP_ROOT "/memory"
+#define CGROUP_UNLIMITED              (1.0e18)  /* v1 reports "no limit" as a huge number */
+
+static const char* level_names[PL_MONITOR_LEVELS] = { "none", "moderate", "critical" };
+
+static const MemoryPressureLevel pressure_levels[PL_MONITOR_LEVELS] = {
+    MemoryPressureLevel::kNone,
+    MemoryPressureLevel::kModerate,
+    MemoryPressureLevel::kCritical,
+};
+
+/*
+ * All the state for the monitor thread.  This is allocated once and never
+ * released, so that it is still valid if the thread is running while the
+ * process exits.
+ */
+struct MonitorState {
+    MonitorState() : thread(0), running(false), suspended(false), interval_ms(0),
+                     moderate(0), critical(0), level(PL_MONITOR_LEVEL_NONE) {}
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread* thread;
+    bool running;
+    std::atomic<bool> suspended;  /* stopped for a fork; start again with the same options */
+    long interval_ms;
+    double moderate;
+    double critical;
+    std::string current_file;
+    std::string max_file;
+    int level;  /* last level sent to the isolates */
+};
+
+static MonitorState* monitor = new MonitorState;
+
+const char* pl_monitor_level_name(int level)
+{
+    return level_names[level];
+}
+
+/* Read a number of bytes from a cgroup file; "max" means no limit. */
+static bool read_bytes(const std::string& path, double* bytes)
+{
+    FILE* fp = fopen(path.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char buf[64];
+    bool ok = fgets(buf, sizeof(buf), fp) != 0;
+    fclose(fp);
+    if (!ok) {
+        return false;
+    }
+    if (strncmp(buf, "max", 3) == 0) {
+        *bytes = CGROUP_UNLIMITED;
+        return true;
+    }
+    char* end = 0;
+    *bytes = strtod(buf, &end);
+    return end != buf;
+}
+
+static bool try_cgroup_files(const std::string& dir, const char* current, const char* max)
+{
+    double current_bytes = 0;
+    double max_bytes = 0;
+    std::string current_file = dir + "/" + current;
+    std::string max_file = dir + "/" + max;
+    if (!read_bytes(current_file, &current_bytes) || !read_bytes(max_file, &max_bytes)) {
+        return false;
+    }
+    if (max_bytes <= 0 || max_bytes >= CGROUP_UNLIMITED) {
+        /* there is a cgroup, but it has no memory limit */
+        return false;
+    }
+    monitor->current_file = current_file;
+    monitor->max_file = max_file;
+    return true;
+}
+
+/*
+ * Find the memory files for our cgroup, looking at /proc/self/cgroup: the
+ * line for cgroup v2 looks like "0::/path", the one for the v1 memory
+ * controller looks like "4:memory:/path".  Inside a container, the cgroup is
+ * usually mounted as the root, so we also try that.
+ */
+static bool find_cgroup_files(void)
+{
+    std::string v2_path;
+    std::string v1_path;
+    FILE* fp = fopen("/proc/self/cgroup", "r");
+    if (fp) {
+        char line[1024];
+        while (fgets(line, sizeof(line), fp)) {
+            line[strcspn(line, "\n")] = '\0';
+            char* controllers = strchr(line, ':');
+            char* path = controllers ? strchr(controllers + 1, ':') : 0;
+            if (!path) {
+                continue;
+            }
+            *path++ = '\0';
+            ++controllers;
+            if (strcmp(line, "0") == 0 && controllers[0] == '\0') {
+                v2_path = path;
+                continue;
+            }
+            std::string list = std::string(",") + controllers + ",";
+            if (list.find(",memory,") != std::string::npos) {
+                v1_path = path;
+            }
+        }
+        fclose(fp);
+    }
+
+    return try_cgroup_files(CGROUP_ROOT + v2_path, "memory.current", "memory.max") ||
+           try_cgroup_files(CGROUP_ROOT, "memory.current", "memory.max") ||
+           try_cgroup_files(CGROUP_V1_MEMORY_ROOT + v1_path, "memory.usage_in_bytes", "memory.limit_in_bytes") ||
+           try_cgroup_files(CGROUP_V1_MEMORY_ROOT, "memory.usage_in_bytes", "memory.limit_in_bytes");
+}
+
+static void notify_context(V8Context* ctx, void* data)
+{
+    int level = *(int*) data;
+    ctx->isolate->MemoryPressureNotification(pressure_levels[level]);
+    pl_stats_record_memory_pressure(ctx, level);
+}
+
+static void monitor_check(void)
+{
+    double current = 0;
+    double max = 0;
+    if (!read_bytes(monitor->current_file, &current) || !read_bytes(monitor->max_file, &max)) {
+        return;
+    }
+    pl_metrics_cgroup_memory(current, max < CGROUP_UNLIMITED ? max : 0);
+
+    int level = PL_MONITOR_LEVEL_NONE;
+    if (max > 0 && max < CGROUP_UNLIMITED) {
+        double usage = current / max;
+        if (usage >= monitor->critical) {
+            level = PL_MONITOR_LEVEL_CRITICAL;
+        } else if (usage >= monitor->moderate) {
+            level = PL_MONITOR_LEVEL_MODERATE;
+        }
+    }
+    if (level == monitor->level) {
+        return;
+    }
+
+    /* only tell the isolates when the level changes */
+    monitor->level = level;
+    pl_metrics_for_each_context(notify_context, &level);
+    pl_metrics_memory_pressure(level);
+}
+
+static void monitor_loop(void)
+{
+    std::unique_lock<std::mutex> lock(monitor->mutex);
+    while (monitor->running) {
+        monitor_check();
+        monitor->cv.wait_for(lock, std::chrono::milliseconds(monitor->interval_ms));
+    }
+}
+
+/* Start the thread, with the options already in the state; the lock must be held. */
+static void start_thread(void)
+{
+    monitor->level = PL_MONITOR_LEVEL_NONE;
+    monitor->running = true;
+    monitor->thread = new std::thread(monitor_loop);
+}
+
+/* Stop the thread and wait for it to finish; return true if it was running. */
+static bool stop_thread(void)
+{
+    std::thread* thread = 0;
+    {
+        std::lock_guard<std::mutex> lock(monitor->mutex);
+        thread = monitor->thread;
+        monitor->thread = 0;
+        monitor->running = false;
+        monitor->cv.notify_one();
+    }
+    if (!thread) {
+        return false;
+    }
+    thread->join();
+    delete thread;
+    return true;
+}
+
+int pl_monitor_start(pTHX_ HV* opt)
+{
+    long interval_ms = MONITOR_DEFAULT_INTERVAL_MS;
+    double moderate = MONITOR_DEFAULT_MODERATE;
+    double critical = MONITOR_DEFAULT_CRITICAL;
+    const char* current_file = 0;
+    const char* max_file = 0;
+
+    if (opt) {
+        hv_iterinit(opt);
+        while (1) {
+            SV* value = 0;
+            I32 klen = 0;
+            char* kstr = 0;
+            HE* entry = hv_iternext(opt);
+            if (!entry) {
+                break; /* no more hash keys */
+            }
+            kstr = hv_iterkey(entry, &klen);
+            if (!kstr || klen < 0) {
+                continue; /* invalid key */
+            }
+            value = hv_iterval(opt, entry);
+            if (!value) {
+                continue; /* invalid value */
+            }
+            if (memcmp(kstr, MONITOR_OPT_NAME_INTERVAL_MS, klen) == 0) {
+                long param = SvIV(value);
+                interval_ms = param > MONITOR_MINIMUM_INTERVAL_MS ? param : MONITOR_MINIMUM_INTERVAL_MS;
+                continue;
+            }
+            if (memcmp(kstr, MONITOR_OPT_NAME_MODERATE, klen) == 0) {
+                moderate = SvNV(value);
+                continue;
+            }
+            if (memcmp(kstr, MONITOR_OPT_NAME_CRITICAL, klen) == 0) {
+                critical = SvNV(value);
+                continue;
+            }
+            if (memcmp(kstr, MONITOR_OPT_NAME_CURRENT_FILE, klen) == 0) {
+                current_file = SvPV_nolen(value);
+                continue;
+            }
+            if (memcmp(kstr, MONITOR_OPT_NAME_MAX_FILE, klen) == 0) {
+                max_file = SvPV_nolen(value);
+                continue;
+            }
+            croak("Unknown option %*.*s\n", (int) klen, (int) klen, kstr);
+        }
+    }
+    if (moderate <= 0 || critical <= 0 || moderate > critical) {
+        croak("Memory monitor thresholds must be positive, with %s <= %s\n",
+              MONITOR_OPT_NAME_MODERATE, MONITOR_OPT_NAME_CRITICAL);
+    }
+    if (!current_file != !max_file) {
+        croak("Memory monitor options %s and %s must be given together\n",
+              MONITOR_OPT_NAME_CURRENT_FILE, MONITOR_OPT_NAME_MAX_FILE);
+    }
+
+    pl_monitor_stop();
+
+    std::lock_guard<std::mutex> lock(monitor->mutex);
+    if (current_file) {
+        monitor->current_file = current_file;
+        monitor->max_file = max_file;
+    } else if (!find_cgroup_files()) {
+        return 0;
+    }
+    monitor->interval_ms = interval_ms;
+    monitor->moderate = moderate;
+    monitor->critical = critical;
+    start_thread();
+    return 1;
+}
+
+void pl_monitor_stop(void)
+{
+    stop_thread();
+    monitor->suspended = false;
+}
+
+void pl_monitor_suspend(void)
+{
+    if (stop_thread()) {
+        monitor->suspended = true;
+    }
+}
+
+void pl_monitor_resume(void)
+{
+    if (!monitor->suspended) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(monitor->mutex);
+    if (monitor->suspended.exchange(false) && !monitor->thread) {
+        start_thread();
+    }
+}
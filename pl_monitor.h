@@ -0,0 +1,45 @@
+#ifndef PL_MONITOR_H
+#define PL_MONITOR_H
+
+#include "pl_config.h"
+#include "ppport.h"
+
+/*
+ * Keep the process under the memory limit of its container, by shrinking the
+ * JS heaps before the kernel kills us.
+ *
+ * When started, a single thread for the whole process reads the memory usage
+ * and limit for the cgroup of the process (memory.current / memory.max for
+ * cgroup v2, memory.usage_in_bytes / memory.limit_in_bytes for v1) every
+ * interval_ms milliseconds.  When the usage crosses one of the configured
+ * thresholds (as a fraction of the limit), the new memory pressure level is
+ * sent to all live isolates with MemoryPressureNotification, and the event is
+ * recorded in the stats for each context and in the process-wide metrics.
+ *
+ * V8 acts on a notification sent from another thread by posting tasks for the
+ * isolate; V8Context runs them when it is next entered (and after running the
+ * event loop), so an isolate that is not used at all does not shrink until
+ * its next call.
+ *
+ * pl_monitor_start returns false if there is no cgroup memory limit to
+ * monitor (no cgroup memory files, or a limit of "max"); pl_monitor_stop
+ * stops the thread.
+ *
+ * Threads do not survive a fork: pl_monitor_suspend stops the thread before
+ * forking, remembering that it was running, and pl_monitor_resume starts it
+ * again with the same options (it does nothing, without taking a lock, when
+ * the monitor was not suspended).
+ */
+#define PL_MONITOR_LEVEL_NONE       0
+#define PL_MONITOR_LEVEL_MODERATE   1
+#define PL_MONITOR_LEVEL_CRITICAL   2
+#define PL_MONITOR_LEVELS           3
+
+int pl_monitor_start(pTHX_ HV* opt);
+void pl_monitor_stop(void);
+void pl_monitor_suspend(void);
+void pl_monitor_resume(void);
+
+const char* pl_monitor_level_name(int level);
+
+#endif
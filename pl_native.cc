@@ -44,21 +44,40 @@ static void native_now_ms(const FunctionCallbackInfo<Value>& args)
     args.GetReturnValue().Set(Local<Object>::Cast(Number::New(args.GetIsolate(), now)));
 }
 
+static struct Data {
+    const char* name;
+    Handler func;
+} native_functions[] = {
+    { "print"       , native_print  },
+    { "version"     , native_version },
+    { "timestamp_ms", native_now_ms },
+};
+
 int pl_register_native_functions(V8Context* ctx, Local<ObjectTemplate>& object_template)
 {
-    static struct Data {
-        const char* name;
-        Handler func;
-    } data[] = {
-        { "print"       , native_print  },
-        { "version"     , native_version },
-        { "timestamp_ms", native_now_ms },
-    };
-    int n = sizeof(data) / sizeof(data[0]);
+    return pl_register_native_functions(ctx->isolate, object_template);
+}
+
+int pl_register_native_functions(Isolate* isolate, Local<ObjectTemplate>& object_template)
+{
+    int n = sizeof(native_functions) / sizeof(native_functions[0]);
     for (int j = 0; j < n; ++j) {
         object_template->Set(
-                String::NewFromUtf8(ctx->isolate, data[j].name, NewStringType::kNormal).ToLocalChecked(),
-                FunctionTemplate::New(ctx->isolate, data[j].func));
+                String::NewFromUtf8(isolate, native_functions[j].name, NewStringType::kNormal).ToLocalChecked(),
+                FunctionTemplate::New(isolate, native_functions[j].func));
     }
     return n;
 }
+
+const intptr_t* pl_native_external_references()
+{
+    static intptr_t refs[sizeof(native_functions) / sizeof(native_functions[0]) + 1];
+    if (!refs[0]) {
+        int n = sizeof(native_functions) / sizeof(native_functions[0]);
+        for (int j = 0; j < n; ++j) {
+            refs[j] = reinterpret_cast<intptr_t>(native_functions[j].func);
+        }
+        refs[n] = 0;
+    }
+    return refs;
+}
@@ -4,5 +4,12 @@
 #include "V8Context.h"
 
 int pl_register_native_functions(V8Context* ctx, Local<ObjectTemplate>& object_template);
+int pl_register_native_functions(Isolate* isolate, Local<ObjectTemplate>& object_template);
+
+/*
+ * Null-terminated array with the addresses of all native functions, which V8
+ * needs to serialize / deserialize them in a startup snapshot.
+ */
+const intptr_t* pl_native_external_references();
 
 #endif
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include "pl_v8.h"
+#include "pl_persist.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+struct PersistData {
+    PersistData(uint8_t* data, size_t size) :
+        data(data), size(size) {}
+    ~PersistData() { free(data); }
+
+    uint8_t* data;  /* serialized JS value, allocated by ValueSerializer */
+    size_t size;
+};
+
+/* All persistent values, keyed by context and JS name. */
+typedef std::pair<V8Context*, std::string> PersistKey;
+typedef std::map<PersistKey, PersistData*> PersistMap;
+static PersistMap persist_map;
+
+static bool set_slot(V8Context* ctx, Local<Context>& context, const char* name, const Local<Value>& value)
+{
+    Local<Object> parent;
+    Local<Value> slot;
+    TryCatch try_catch(ctx->isolate);
+    if (!find_parent(ctx, name, context, parent, slot, true)) {
+        return false;
+    }
+    return parent->Set(context, slot, value).FromMaybe(false);
+}
+
+int pl_persist_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value)
+{
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    Local<Object> object = pl_perl_to_v8(aTHX_ value, ctx);
+
+    std::pair<uint8_t*, size_t> buffer(0, 0);
+    bool ok = false;
+    {
+        ValueSerializer serializer(ctx->isolate);
+        serializer.WriteHeader();
+        TryCatch try_catch(ctx->isolate);
+        ok = serializer.WriteValue(context, object).FromMaybe(false);
+        if (ok) {
+            buffer = serializer.Release();
+        }
+    }
+    if (!ok) {
+        /* V8Context croaks with this once out of V8 */
+        pl_fail(aTHX_ ctx, "Could not serialize persistent value for %s (functions cannot be persisted)\n", name);
+        return 0;
+    }
+
+    /* only keep the value if it can be set, or every reset would fail */
+    if (!set_slot(ctx, context, name, object)) {
+        free(buffer.first);
+        pl_fail(aTHX_ ctx, "Could not set persistent value for %s\n", name);
+        return 0;
+    }
+
+    PersistKey key(ctx, name);
+    PersistMap::iterator k = persist_map.find(key);
+    if (k != persist_map.end()) {
+        delete k->second;
+    }
+    persist_map[key] = new PersistData(buffer.first, buffer.second);
+    return 1;
+}
+
+int pl_persist_install(V8Context* ctx)
+{
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    int count = 0;
+    PersistMap::iterator k = persist_map.lower_bound(PersistKey(ctx, std::string()));
+    for (; k != persist_map.end() && k->first.first == ctx; ++k) {
+        const PersistData* data = k->second;
+        ValueDeserializer deserializer(ctx->isolate, data->data, data->size);
+        TryCatch try_catch(ctx->isolate);
+        Local<Value> value;
+        if (!deserializer.ReadHeader(context).FromMaybe(false) ||
+            !deserializer.ReadValue(context).ToLocal(&value)) {
+            continue;
+        }
+        /*
+         * A value may not fit any more (a persistent "a" set to a number
+         * after "a.b"); skip it, we must not fail in the middle of a reset.
+         */
+        if (set_slot(ctx, context, k->first.second.c_str(), value)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void pl_persist_destroy(V8Context* ctx)
+{
+    PersistMap::iterator k = persist_map.lower_bound(PersistKey(ctx, std::string()));
+    while (k != persist_map.end() && k->first.first == ctx) {
+        delete k->second;
+        persist_map.erase(k++);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef PL_PERSIST_H
+#define PL_PERSIST_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Set a global / nested property from Perl data, and keep it so that it is
+ * installed again every time the context is reset.
+ *
+ * The Perl data is converted only once; the resulting JS value is serialized
+ * with a ValueSerializer, and the bytes are kept in a table keyed by context
+ * and name.  We cannot keep the JS value itself, because a reset disposes of
+ * the whole isolate; instead, pl_persist_install deserializes each value
+ * straight into the new context, without going through Perl at all.  A value
+ * is only kept if it could be set; values that cannot be installed any more
+ * are skipped, so that a reset never fails.
+ *
+ * pl_persist_destroy releases all the values kept for a context, when it is
+ * destroyed.
+ */
+int pl_persist_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value);
+int pl_persist_install(V8Context* ctx);
+void pl_persist_destroy(V8Context* ctx);
+
+#endif
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <v8-profiler.h>
+#include "pl_profiler.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+#define PROFILER_OPT_NAME_SAMPLING_INTERVAL_US "sampling_interval_us"
+#define PROFILER_OPT_NAME_PATH                 "path"
+#define PROFILER_OPT_NAME_FOLDED               "folded"
+
+#define PROFILER_EXTENSION                     ".cpuprofile"
+
+struct ProfileData {
+    std::string path;    /* where to write the .cpuprofile */
+    std::string folded;  /* where to write the folded stacks, if not empty */
+};
+
+/* One profiler per context, and all running profiles, keyed by context and name. */
+typedef std::map<V8Context*, CpuProfiler*> ProfilerMap;
+static ProfilerMap profiler_map;
+typedef std::pair<V8Context*, std::string> ProfileKey;
+typedef std::map<ProfileKey, ProfileData> ProfileMap;
+static ProfileMap profile_map;
+
+static void write_json_string(FILE* fp, const char* str)
+{
+    fputc('"', fp);
+    for (const unsigned char* p = (const unsigned char*) str; *p; ++p) {
+        switch (*p) {
+            case '"':  fputs("\\\"", fp); break;
+            case '\\': fputs("\\\\", fp); break;
+            case '\n': fputs("\\n", fp); break;
+            case '\r': fputs("\\r", fp); break;
+            case '\t': fputs("\\t", fp); break;
+            default:
+                if (*p < 0x20) {
+                    fprintf(fp, "\\u%04x", *p);
+                } else {
+                    fputc(*p, fp);
+                }
+                break;
+        }
+    }
+    fputc('"', fp);
+}
+
+static void write_json_node(FILE* fp, const CpuProfileNode* node, bool first)
+{
+    /* line and column numbers are 1-based in V8, 0-based in DevTools */
+    fprintf(fp, "%s\n{\"id\":%u,\"callFrame\":{\"functionName\":", first ? "" : ",", node->GetNodeId());
+    write_json_string(fp, node->GetFunctionNameStr());
+    fprintf(fp, ",\"scriptId\":\"%d\",\"url\":", node->GetScriptId());
+    write_json_string(fp, node->GetScriptResourceNameStr());
+    fprintf(fp, ",\"lineNumber\":%d,\"columnNumber\":%d},\"hitCount\":%u",
+            node->GetLineNumber() - 1, node->GetColumnNumber() - 1, node->GetHitCount());
+    int children = node->GetChildrenCount();
+    if (children) {
+        fputs(",\"children\":[", fp);
+        for (int j = 0; j < children; ++j) {
+            fprintf(fp, "%s%u", j ? "," : "", node->GetChild(j)->GetNodeId());
+        }
+        fputc(']', fp);
+    }
+    fputc('}', fp);
+
+    for (int j = 0; j < children; ++j) {
+        write_json_node(fp, node->GetChild(j), false);
+    }
+}
+
+static void write_cpuprofile(FILE* fp, const CpuProfile* profile)
+{
+    fputs("{\"nodes\":[", fp);
+    write_json_node(fp, profile->GetTopDownRoot(), true);
+    fprintf(fp, "],\n\"startTime\":%lld,\"endTime\":%lld,\n\"samples\":[",
+            (long long) profile->GetStartTime(), (long long) profile->GetEndTime());
+    int samples = profile->GetSamplesCount();
+    for (int j = 0; j < samples; ++j) {
+        fprintf(fp, "%s%u", j ? "," : "", profile->GetSample(j)->GetNodeId());
+    }
+    fputs("],\n\"timeDeltas\":[", fp);
+    int64_t last = profile->GetStartTime();
+    for (int j = 0; j < samples; ++j) {
+        int64_t timestamp = profile->GetSampleTimestamp(j);
+        fprintf(fp, "%s%lld", j ? "," : "", (long long) (timestamp - last));
+        last = timestamp;
+    }
+    fputs("]}\n", fp);
+}
+
+/* A frame in a folded stack: "name (url:line)", without any semicolons. */
+static std::string folded_frame(const CpuProfileNode* node)
+{
+    std::string frame = node->GetFunctionNameStr();
+    if (frame.empty()) {
+        frame = "(anonymous)";
+    }
+    const char* url = node->GetScriptResourceNameStr();
+    if (url && url[0]) {
+        char line[32];
+        snprintf(line, sizeof(line), ":%d)", node->GetLineNumber());
+        frame += " (";
+        frame += url;
+        frame += line;
+    }
+    for (size_t j = 0; j < frame.length(); ++j) {
+        if (frame[j] == ';') {
+            frame[j] = ':';
+        }
+    }
+    return frame;
+}
+
+static void write_folded_node(FILE* fp, const CpuProfileNode* node, std::vector<std::string>& stack)
+{
+    stack.push_back(folded_frame(node));
+    unsigned hits = node->GetHitCount();
+    if (hits) {
+        for (size_t j = 0; j < stack.size(); ++j) {
+            fprintf(fp, "%s%s", j ? ";" : "", stack[j].c_str());
+        }
+        fprintf(fp, " %u\n", hits);
+    }
+    int children = node->GetChildrenCount();
+    for (int j = 0; j < children; ++j) {
+        write_folded_node(fp, node->GetChild(j), stack);
+    }
+    stack.pop_back();
+}
+
+static void write_folded(FILE* fp, const CpuProfile* profile)
+{
+    /* the root node is not a real frame */
+    std::vector<std::string> stack;
+    const CpuProfileNode* root = profile->GetTopDownRoot();
+    int children = root->GetChildrenCount();
+    for (int j = 0; j < children; ++j) {
+        write_folded_node(fp, root->GetChild(j), stack);
+    }
+}
+
+int pl_profiler_start(pTHX_ V8Context* ctx, const char* name, HV* opt)
+{
+    ProfileKey key(ctx, name);
+    if (profile_map.find(key) != profile_map.end()) {
+        pl_fail(aTHX_ ctx, "Already profiling with name %s\n", name);
+        return 0;
+    }
+
+    int sampling_interval_us = 0;
+    ProfileData data;
+    data.path = std::string(name) + PROFILER_EXTENSION;
+    if (opt) {
+        hv_iterinit(opt);
+        while (1) {
+            SV* value = 0;
+            I32 klen = 0;
+            char* kstr = 0;
+            HE* entry = hv_iternext(opt);
+            if (!entry) {
+                break; /* no more hash keys */
+            }
+            kstr = hv_iterkey(entry, &klen);
+            if (!kstr || klen < 0) {
+                continue; /* invalid key */
+            }
+            value = hv_iterval(opt, entry);
+            if (!value) {
+                continue; /* invalid value */
+            }
+            if (memcmp(kstr, PROFILER_OPT_NAME_SAMPLING_INTERVAL_US, klen) == 0) {
+                int param = SvIV(value);
+                sampling_interval_us = param > 0 ? param : 0;
+                continue;
+            }
+            if (memcmp(kstr, PROFILER_OPT_NAME_PATH, klen) == 0) {
+                data.path = SvPV_nolen(value);
+                continue;
+            }
+            if (memcmp(kstr, PROFILER_OPT_NAME_FOLDED, klen) == 0) {
+                data.folded = SvPV_nolen(value);
+                continue;
+            }
+            pl_fail(aTHX_ ctx, "Unknown option %*.*s\n", (int) klen, (int) klen, kstr);
+            return 0;
+        }
+    }
+
+    CpuProfiler* profiler = 0;
+    ProfilerMap::iterator k = profiler_map.find(ctx);
+    if (k != profiler_map.end()) {
+        profiler = k->second;
+    } else {
+        profiler = CpuProfiler::New(ctx->isolate);
+        profiler_map[ctx] = profiler;
+    }
+
+    /* this only affects profiles started from now on */
+    if (sampling_interval_us) {
+        profiler->SetSamplingInterval(sampling_interval_us);
+    }
+
+    Local<String> title = String::NewFromUtf8(ctx->isolate, name, NewStringType::kNormal).ToLocalChecked();
+    profiler->StartProfiling(title, true);
+    profile_map[key] = data;
+    return 1;
+}
+
+SV* pl_profiler_stop(pTHX_ V8Context* ctx, const char* name)
+{
+    ProfileKey key(ctx, name);
+    ProfileMap::iterator k = profile_map.find(key);
+    if (k == profile_map.end()) {
+        pl_fail(aTHX_ ctx, "Not profiling with name %s\n", name);
+        return &PL_sv_undef;
+    }
+    ProfileData data = k->second;
+    profile_map.erase(k);
+
+    CpuProfiler* profiler = profiler_map[ctx];
+    Local<String> title = String::NewFromUtf8(ctx->isolate, name, NewStringType::kNormal).ToLocalChecked();
+    CpuProfile* profile = profiler->StopProfiling(title);
+    if (!profile) {
+        pl_fail(aTHX_ ctx, "Could not get CPU profile for %s\n", name);
+        return &PL_sv_undef;
+    }
+
+    /* open all files first, so that we always delete the profile */
+    const char* failed = 0;
+    FILE* fp = fopen(data.path.c_str(), "w");
+    FILE* folded = 0;
+    if (!fp) {
+        failed = data.path.c_str();
+    } else if (!data.folded.empty()) {
+        folded = fopen(data.folded.c_str(), "w");
+        if (!folded) {
+            failed = data.folded.c_str();
+        }
+    }
+    if (!failed) {
+        write_cpuprofile(fp, profile);
+        if (folded) {
+            write_folded(folded, profile);
+        }
+    }
+    if (fp) {
+        fclose(fp);
+    }
+    if (folded) {
+        fclose(folded);
+    }
+    profile->Delete();
+    if (failed) {
+        pl_fail(aTHX_ ctx, "Could not open %s for writing CPU profile for %s\n", failed, name);
+        return &PL_sv_undef;
+    }
+    return newSVpvn(data.path.c_str(), data.path.length());
+}
+
+int pl_profiler_active(V8Context* ctx)
+{
+    ProfileMap::iterator p = profile_map.lower_bound(ProfileKey(ctx, ""));
+    return p != profile_map.end() && p->first.first == ctx;
+}
+
+void pl_profiler_tear_down(V8Context* ctx)
+{
+    ProfileMap::iterator p = profile_map.lower_bound(ProfileKey(ctx, ""));
+    while (p != profile_map.end() && p->first.first == ctx) {
+        profile_map.erase(p++);
+    }
+
+    /* this also deletes any profiles still running */
+    ProfilerMap::iterator k = profiler_map.find(ctx);
+    if (k != profiler_map.end()) {
+        k->second->Dispose();
+        profiler_map.erase(k);
+    }
+}
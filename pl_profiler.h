@@ -0,0 +1,40 @@
+#ifndef PL_PROFILER_H
+#define PL_PROFILER_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Sample the JS code running in a context with the V8 CPU profiler.
+ *
+ * There is one CpuProfiler per context, created the first time profiling is
+ * started; it can run several profiles at once, each one with its own name.
+ * When a profile is stopped, it is written as a .cpuprofile JSON file (the
+ * format used by Chrome DevTools) and, optionally, as folded stacks (one line
+ * per stack, with the number of samples), which is the input for most flame
+ * graph tools.
+ *
+ * pl_profiler_start: the options are sampling_interval_us, path (for the
+ * .cpuprofile file, by default the profile name plus ".cpuprofile") and
+ * folded (the path for the folded stacks).
+ *
+ * pl_profiler_stop: return the path where the profile was written.
+ *
+ * Both run inside the isolate, so they report errors with pl_fail.
+ *
+ * pl_profiler_active: return true if there are profiles running for a
+ * context, which must then not be recycled.
+ *
+ * pl_profiler_tear_down: discard all profiles for a context, before its
+ * isolate is disposed.
+ */
+int pl_profiler_start(pTHX_ V8Context* ctx, const char* name, HV* opt);
+SV* pl_profiler_stop(pTHX_ V8Context* ctx, const char* name);
+int pl_profiler_active(V8Context* ctx);
+void pl_profiler_tear_down(V8Context* ctx);
+
+#endif
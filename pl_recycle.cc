@@ -0,0 +1,170 @@
+#include <future>
+#include <map>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+#include "pl_util.h"
+#include "pl_recycle.h"
+#include "V8Context.h"
+
+#define RECYCLE_REASON_EVALS      "evals"
+#define RECYCLE_REASON_SECONDS    "seconds"
+#define RECYCLE_REASON_HEAP_BYTES "heap_bytes"
+
+/* V8's default for --stack-size on 64-bit platforms, in KB */
+#define RECYCLE_STACK_SIZE_KB 984
+
+struct RecycleData {
+    std::future<Isolate*> next;  /* isolate being created in the background */
+    std::thread disposer;        /* thread disposing of the previous isolate */
+};
+
+/* Background work for each context with a recycling policy. */
+typedef std::map<V8Context*, RecycleData*> RecycleMap;
+static RecycleMap recycle_map;
+
+/* the value of --stack-size, which we cannot query from V8 */
+static size_t stack_size_kb = RECYCLE_STACK_SIZE_KB;
+
+static bool has_policy(V8Context* ctx)
+{
+    return ctx->recycle_after_evals > 0 ||
+           ctx->recycle_after_seconds > 0 ||
+           ctx->recycle_above_heap_bytes > 0;
+}
+
+static RecycleData* get_data(V8Context* ctx)
+{
+    RecycleMap::iterator k = recycle_map.find(ctx);
+    if (k != recycle_map.end()) {
+        return k->second;
+    }
+    RecycleData* data = new RecycleData;
+    recycle_map[ctx] = data;
+    return data;
+}
+
+static void wait_data(RecycleData* data)
+{
+    if (data->next.valid()) {
+        data->next.wait();
+    }
+    if (data->disposer.joinable()) {
+        data->disposer.join();
+    }
+}
+
+void pl_recycle_set_up(V8Context* ctx, const Isolate::CreateParams& create_params)
+{
+    ctx->recycle_evals = 0;
+    ctx->recycle_started_us = now_us();
+    ctx->recycle_reason = 0;
+    if (!has_policy(ctx)) {
+        return;
+    }
+
+    RecycleData* data = get_data(ctx);
+    if (data->next.valid()) {
+        return;
+    }
+    Isolate::CreateParams params = create_params;
+    data->next = std::async(std::launch::async, [params]() {
+        return Isolate::New(params);
+    });
+}
+
+Isolate* pl_recycle_take_isolate(V8Context* ctx)
+{
+    RecycleMap::iterator k = recycle_map.find(ctx);
+    if (k == recycle_map.end() || !k->second->next.valid()) {
+        return 0;
+    }
+    Isolate* isolate = k->second->next.get();
+
+    /*
+     * Isolate::New set the stack limit from the stack of the thread that
+     * created the isolate; set it again from this thread's stack, the way V8
+     * does, or stack overflows in JS would never be detected.
+     */
+    char here;
+    uintptr_t position = reinterpret_cast<uintptr_t>(&here);
+    isolate->SetStackLimit(position - stack_size_kb * 1024);
+    return isolate;
+}
+
+void pl_recycle_parse_flags(const char* flags)
+{
+    static const char* names[] = { "--stack-size", "--stack_size" };
+    for (size_t j = 0; j < sizeof(names) / sizeof(names[0]); ++j) {
+        size_t len = strlen(names[j]);
+        for (const char* p = strstr(flags, names[j]); p; p = strstr(p + len, names[j])) {
+            const char* value = p + len;
+            while (*value == '=' || *value == ' ') {
+                ++value;
+            }
+            long kb = strtol(value, 0, 10);
+            if (kb > 0) {
+                stack_size_kb = kb;
+            }
+        }
+    }
+}
+
+void pl_recycle_dispose_isolate(V8Context* ctx, Isolate* isolate)
+{
+    RecycleData* data = get_data(ctx);
+    if (data->disposer.joinable()) {
+        /* this should have finished long ago */
+        data->disposer.join();
+    }
+    data->disposer = std::thread([isolate]() {
+        isolate->Dispose();
+    });
+}
+
+void pl_recycle_check(V8Context* ctx)
+{
+    if (!has_policy(ctx) || ctx->recycle_reason) {
+        return;
+    }
+
+    ++ctx->recycle_evals;
+    if (ctx->recycle_after_evals > 0 && ctx->recycle_evals >= ctx->recycle_after_evals) {
+        ctx->recycle_reason = RECYCLE_REASON_EVALS;
+        return;
+    }
+    if (ctx->recycle_after_seconds > 0 && (now_us() - ctx->recycle_started_us) >= ctx->recycle_after_seconds * 1000000.0) {
+        ctx->recycle_reason = RECYCLE_REASON_SECONDS;
+        return;
+    }
+    if (ctx->recycle_above_heap_bytes > 0) {
+        HeapStatistics hs;
+        ctx->isolate->GetHeapStatistics(&hs);
+        if (hs.used_heap_size() > ctx->recycle_above_heap_bytes) {
+            ctx->recycle_reason = RECYCLE_REASON_HEAP_BYTES;
+            return;
+        }
+    }
+}
+
+void pl_recycle_wait(void)
+{
+    for (RecycleMap::iterator k = recycle_map.begin(); k != recycle_map.end(); ++k) {
+        wait_data(k->second);
+    }
+}
+
+void pl_recycle_destroy(V8Context* ctx)
+{
+    RecycleMap::iterator k = recycle_map.find(ctx);
+    if (k == recycle_map.end()) {
+        return;
+    }
+    RecycleData* data = k->second;
+    recycle_map.erase(k);
+    wait_data(data);
+    if (data->next.valid()) {
+        data->next.get()->Dispose();
+    }
+    delete data;
+}
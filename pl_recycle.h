@@ -0,0 +1,48 @@
+#ifndef PL_RECYCLE_H
+#define PL_RECYCLE_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Recycle the isolate of a context according to a policy: after a number of
+ * evals, after some time, or once its heap grows above a size.
+ *
+ * pl_recycle_check is called after running code; if it is time to recycle,
+ * it records the reason in the context, and the recycling happens at the
+ * beginning of the next call (so never while JS code is running).  Recycling
+ * is just like a reset: everything that survives a reset (persistent values,
+ * bound scalars, registered classes, the snapshot) is there in the new
+ * isolate.
+ *
+ * To avoid stalling the call that recycles, the work is done in background
+ * threads: when a context with a recycling policy is set up, the isolate for
+ * the next set up is already created in the background, and is handed over
+ * by pl_recycle_take_isolate; old isolates are disposed of, also in the
+ * background, by pl_recycle_dispose_isolate.  An isolate created in another
+ * thread takes its stack limit from that thread, so pl_recycle_take_isolate
+ * sets it again from the calling thread's stack, using the --stack-size that
+ * pl_recycle_parse_flags saw in the V8 flags (or the V8 default).
+ */
+void pl_recycle_set_up(V8Context* ctx, const Isolate::CreateParams& create_params);
+Isolate* pl_recycle_take_isolate(V8Context* ctx);
+void pl_recycle_dispose_isolate(V8Context* ctx, Isolate* isolate);
+void pl_recycle_check(V8Context* ctx);
+void pl_recycle_parse_flags(const char* flags);
+
+/*
+ * Wait for all background work, for example before forking.
+ */
+void pl_recycle_wait(void);
+
+/*
+ * Wait for the background work for a context and release everything, when
+ * it is destroyed.
+ */
+void pl_recycle_destroy(V8Context* ctx);
+
+#endif
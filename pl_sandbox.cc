@@ -0,0 +1,138 @@
+#include <atomic>
+#include "pl_console.h"
+#include "pl_sandbox.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+#define SANDBOX_MB            (1024 * 1024)
+#define SANDBOX_SEMI_SPACES   16    /* fraction of the memory for each semi-space */
+#define SANDBOX_SEMI_MIN_KB   512
+
+/*
+ * An ArrayBuffer allocator that enforces a quota on the total memory used by
+ * live ArrayBuffers.  V8 may free buffers from its background threads, so the
+ * count of used bytes is atomic.
+ */
+class QuotaAllocator : public ArrayBuffer::Allocator {
+    public:
+        QuotaAllocator(size_t quota) :
+            allocator(ArrayBuffer::Allocator::NewDefaultAllocator()),
+            quota(quota), used(0) {}
+        virtual ~QuotaAllocator() { delete allocator; }
+
+        virtual void* Allocate(size_t length) {
+            if (!reserve(length)) {
+                return 0;
+            }
+            void* data = allocator->Allocate(length);
+            if (!data) {
+                used -= length;
+            }
+            return data;
+        }
+        virtual void* AllocateUninitialized(size_t length) {
+            if (!reserve(length)) {
+                return 0;
+            }
+            void* data = allocator->AllocateUninitialized(length);
+            if (!data) {
+                used -= length;
+            }
+            return data;
+        }
+        virtual void Free(void* data, size_t length) {
+            allocator->Free(data, length);
+            used -= length;
+        }
+
+    private:
+        ArrayBuffer::Allocator* allocator;
+        size_t quota;
+        std::atomic<size_t> used;
+
+        bool reserve(size_t length) {
+            size_t current = used.load();
+            do {
+                if (current + length > quota) {
+                    return false;
+                }
+            } while (!used.compare_exchange_weak(current, current + length));
+            return true;
+        }
+};
+
+static size_t near_heap_limit(void* data, size_t current_heap_limit, size_t initial_heap_limit)
+{
+    V8Context* ctx = (V8Context*) data;
+    ctx->terminate_reason = PL_TERMINATE_MEMORY;
+    ctx->initial_heap_limit = initial_heap_limit;
+    ctx->isolate->TerminateExecution();
+
+    /* give V8 enough room to unwind the JS stack */
+    return current_heap_limit + initial_heap_limit;
+}
+
+ArrayBuffer::Allocator* pl_sandbox_create_allocator(V8Context* ctx, Isolate::CreateParams& create_params)
+{
+    size_t limit = ctx->max_allocated_bytes;
+    if (!limit) {
+        return ArrayBuffer::Allocator::NewDefaultAllocator();
+    }
+
+    size_t semi_space_kb = limit / SANDBOX_SEMI_SPACES / 1024;
+    if (semi_space_kb < SANDBOX_SEMI_MIN_KB) {
+        semi_space_kb = SANDBOX_SEMI_MIN_KB;
+    }
+    size_t old_space_mb = (limit + SANDBOX_MB - 1) / SANDBOX_MB;
+    create_params.constraints.set_max_semi_space_size_in_kb(semi_space_kb);
+    create_params.constraints.set_max_old_space_size(old_space_mb);
+    return new QuotaAllocator(limit);
+}
+
+void pl_sandbox_set_up(V8Context* ctx)
+{
+    ctx->terminate_reason = PL_TERMINATE_NONE;
+    if (!ctx->max_allocated_bytes) {
+        return;
+    }
+    ctx->isolate->AddNearHeapLimitCallback(near_heap_limit, ctx);
+}
+
+void pl_sandbox_tear_down(V8Context* ctx)
+{
+    if (!ctx->max_allocated_bytes) {
+        return;
+    }
+    ctx->isolate->RemoveNearHeapLimitCallback(near_heap_limit, 0);
+}
+
+void pl_sandbox_report_termination(V8Context* ctx)
+{
+    switch (ctx->terminate_reason) {
+        case PL_TERMINATE_MEMORY:
+            pl_show_error(ctx, "error: Error: allocation failure\n");
+
+            /* go back to the original limit, and keep watching it */
+            ctx->isolate->RemoveNearHeapLimitCallback(near_heap_limit, ctx->initial_heap_limit);
+            ctx->isolate->AddNearHeapLimitCallback(near_heap_limit, ctx);
+            break;
+        case PL_TERMINATE_TIMEOUT:
+            pl_show_error(ctx, "error: RangeError: execution timeout\n");
+            break;
+        default:
+            pl_show_error(ctx, "error: Error: execution terminated\n");
+            break;
+    }
+    ctx->terminate_reason = PL_TERMINATE_NONE;
+    ctx->isolate->CancelTerminateExecution();
+}
+
+void pl_sandbox_cancel_termination(V8Context* ctx)
+{
+    if (ctx->terminate_reason == PL_TERMINATE_MEMORY) {
+        ctx->isolate->RemoveNearHeapLimitCallback(near_heap_limit, ctx->initial_heap_limit);
+        ctx->isolate->AddNearHeapLimitCallback(near_heap_limit, ctx);
+    }
+    ctx->terminate_reason = PL_TERMINATE_NONE;
+    ctx->isolate->CancelTerminateExecution();
+}
@@ -0,0 +1,49 @@
+#ifndef PL_SANDBOX_H
+#define PL_SANDBOX_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/* Why we asked V8 to terminate the execution of JS code */
+#define PL_TERMINATE_NONE    0
+#define PL_TERMINATE_MEMORY  1
+#define PL_TERMINATE_TIMEOUT 2
+
+/*
+ * Create the ArrayBuffer allocator for a context: if there is a limit on the
+ * memory it can use, the allocator keeps track of the memory used by all the
+ * ArrayBuffers and fails any allocation that would go over the limit, which
+ * makes V8 throw a RangeError.  Also compute the heap constraints for the
+ * limit.
+ */
+ArrayBuffer::Allocator* pl_sandbox_create_allocator(V8Context* ctx, Isolate::CreateParams& create_params);
+
+/*
+ * Set up / tear down the memory limits for a newly created isolate: when the
+ * heap gets near its limit, V8 calls us back and we terminate the execution
+ * of the running JS code (raising the limit a bit, so that V8 can unwind the
+ * JS stack), instead of letting V8 abort the whole process.
+ */
+void pl_sandbox_set_up(V8Context* ctx);
+void pl_sandbox_tear_down(V8Context* ctx);
+
+/*
+ * Called when the execution of JS code was terminated: report the reason as
+ * an error and leave the isolate ready to run code again.  Only called for
+ * the outermost JS code; when nested calls are terminated, the termination
+ * must go on unwinding the JS code that called them.
+ */
+void pl_sandbox_report_termination(V8Context* ctx);
+
+/*
+ * Called when the JS code completed, but we had asked V8 to terminate it
+ * anyway (it finished just as it hit a limit): forget about the termination,
+ * so that it does not hit the next piece of code we run.
+ */
+void pl_sandbox_cancel_termination(V8Context* ctx);
+
+#endif
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include "pl_util.h"
+#include "pl_native.h"
+#include "pl_snapshot.h"
+#include "ppport.h"
+
+static const char* ToCString(const String::Utf8Value& value)
+{
+    return *value ? *value : "<string conversion failed>";
+}
+
+static bool run_code(pTHX_ Isolate* isolate, Local<Context>& context, const char* code, SV* error)
+{
+    TryCatch try_catch(isolate);
+    Local<String> source = String::NewFromUtf8(isolate, code, NewStringType::kNormal).ToLocalChecked();
+    Local<Script> script;
+    Local<Value> result;
+    if (Script::Compile(context, source).ToLocal(&script) &&
+        script->Run(context).ToLocal(&result)) {
+        return true;
+    }
+    String::Utf8Value exception(isolate, try_catch.Exception());
+    sv_setpv(error, ToCString(exception));
+    return false;
+}
+
+int pl_snapshot_create(pTHX_ const char* code, const char* path)
+{
+    /*
+     * Write to a temporary file and rename it when done: other processes may
+     * have the old snapshot mapped, and truncating it under them would make
+     * them crash.
+     */
+    SV* temp = sv_2mortal(newSVpvf("%s.tmp", path));
+    const char* temp_path = SvPV_nolen(temp);
+    FILE* fp = fopen(temp_path, "wb");
+    if (!fp) {
+        croak("Could not open snapshot file %s for writing\n", temp_path);
+    }
+
+    SV* error = sv_2mortal(newSVpvs(""));
+    int ret = 0;
+    {
+        StartupData blob = { 0, 0 };
+        SnapshotCreator creator(pl_snapshot_external_references());
+        Isolate* isolate = creator.GetIsolate();
+        {
+            HandleScope handle_scope(isolate);
+            Local<ObjectTemplate> object_template = ObjectTemplate::New(isolate);
+            pl_register_native_functions(isolate, object_template);
+            Local<Context> context = Context::New(isolate, 0, object_template);
+            {
+                Context::Scope context_scope(context);
+                if (!run_code(aTHX_ isolate, context, code, error)) {
+                    context = Local<Context>();
+                }
+            }
+            if (!context.IsEmpty()) {
+                creator.SetDefaultContext(context);
+            }
+        }
+        if (!SvCUR(error)) {
+            blob = creator.CreateBlob(SnapshotCreator::FunctionCodeHandling::kClear);
+        }
+
+        if (blob.data) {
+            ret = blob.raw_size;
+            if (fwrite(blob.data, 1, blob.raw_size, fp) != (size_t) blob.raw_size) {
+                sv_setpvf(error, "could not write %d bytes", blob.raw_size);
+            }
+            delete[] blob.data;
+        } else if (!SvCUR(error)) {
+            sv_setpvs(error, "could not create blob");
+        }
+    }
+    if (fclose(fp) != 0 && !SvCUR(error)) {
+        sv_setpvs(error, "could not close file");
+    }
+    if (!SvCUR(error) && rename(temp_path, path) != 0) {
+        sv_setpvf(error, "could not rename %s", temp_path);
+    }
+    if (SvCUR(error)) {
+        remove(temp_path);
+        croak("Could not create snapshot %s: %s\n", path, SvPV_nolen(error));
+    }
+    return ret;
+}
+
+void pl_snapshot_load(pTHX_ const char* path, StartupData* blob)
+{
+    /* map the file, so that forked processes share the pages */
+    size_t size = 0;
+    const char* data = map_file(path, &size);
+    if (!data) {
+        croak("Could not open snapshot file %s\n", path);
+    }
+    blob->data = data;
+    blob->raw_size = size;
+}
+
+void pl_snapshot_free(StartupData* blob)
+{
+    unmap_file(blob->data, blob->raw_size);
+    blob->data = 0;
+    blob->raw_size = 0;
+}
+
+const intptr_t* pl_snapshot_external_references()
+{
+    return pl_native_external_references();
+}
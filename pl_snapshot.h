@@ -0,0 +1,35 @@
+#ifndef PL_SNAPSHOT_H
+#define PL_SNAPSHOT_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+
+/*
+ * Create a startup snapshot: run some JS code in a fresh context (which has
+ * our native functions in its global object) under a SnapshotCreator, and
+ * write the resulting blob to a file.  Return the size of the blob.
+ *
+ * Only the native functions are in the context when the snapshot is created;
+ * the eventloop and console functions are registered when a context is booted
+ * from the snapshot, so the code cannot use them at the top level.
+ */
+int pl_snapshot_create(pTHX_ const char* code, const char* path);
+
+/*
+ * Load a startup snapshot from a file, so that it can be used to create
+ * isolates, and release it once it is no longer needed.  The blob must
+ * outlive all the isolates created from it.
+ */
+void pl_snapshot_load(pTHX_ const char* path, StartupData* blob);
+void pl_snapshot_free(StartupData* blob);
+
+/*
+ * Null-terminated array with the addresses of all native callbacks that can
+ * appear in a snapshot.
+ */
+const intptr_t* pl_snapshot_external_references();
+
+#endif
@@ -1,8 +1,49 @@
+#include <math.h>
 #include "pl_util.h"
+#include "pl_heap.h"
 #include "pl_stats.h"
+#include "pl_metrics.h"
 #include "ppport.h"
 
-static void save_stat(pTHX_ V8Context* ctx, const char* category, const char* name, double value)
+/* Names for each operation, in the same order as enum PlStat */
+static const char* stat_names[PL_STAT_COUNT] = {
+    "compile",
+    "run",
+    "get",
+    "get_many",
+    "exists",
+    "typeof",
+    "instanceof",
+    "set",
+    "set_many",
+    "set_lazy",
+    "set_persistent",
+    "sync",
+    "bind",
+    "bind_scalar",
+    "remove",
+    "dispatch",
+    "global_objects",
+    "run_gc",
+    "idle_gc",
+    "memory_pressure",
+    "start_profiling",
+    "stop_profiling",
+    "convert",
+    "callback",
+    "gc",
+    "gc_scavenge",
+    "gc_mark_compact",
+    "gc_incremental",
+    "gc_weak_callbacks",
+};
+
+const char* pl_stats_name(PlStat stat)
+{
+    return stat_names[stat];
+}
+
+static void save_stat(pTHX_ V8Context* ctx, const char* category, const char* name, double value, bool add = false)
 {
     STRLEN clen = strlen(category);
     STRLEN nlen = strlen(name);
@@ -29,6 +70,12 @@ static void save_stat(pTHX_ V8Context* ctx, const char* category, const char* na
         }
     }
 
+    if (add) {
+        SV** current = hv_fetch(data, name, nlen, 0);
+        if (current) {
+            value += SvNV(*current);
+        }
+    }
     pvalue = sv_2mortal(newSVnv(value));
     if (hv_store(data, name, nlen, pvalue, 0)) {
         SvREFCNT_inc(pvalue);
@@ -38,23 +85,233 @@ static void save_stat(pTHX_ V8Context* ctx, const char* category, const char* na
     }
 }
 
-void pl_stats_start(pTHX_ V8Context* ctx, Perf* perf)
+static int histogram_bucket(double value)
 {
+    if (value < 1.0) {
+        return 0;
+    }
+    int exponent = 0;
+    double mantissa = frexp(value, &exponent);  /* value = mantissa * 2^exponent, 0.5 <= mantissa < 1 */
+    int bucket = (exponent - 1) * PL_HISTOGRAM_SUB_BUCKETS +
+                 (int) ((mantissa - 0.5) * 2 * PL_HISTOGRAM_SUB_BUCKETS);
+    return bucket < PL_HISTOGRAM_BUCKETS ? bucket : PL_HISTOGRAM_BUCKETS - 1;
+}
+
+void pl_histogram_add(Histogram* histogram, double value)
+{
+    if (value < 0) {
+        value = 0;
+    }
+    if (!histogram->count || value < histogram->min) {
+        histogram->min = value;
+    }
+    if (!histogram->count || value > histogram->max) {
+        histogram->max = value;
+    }
+    ++histogram->count;
+    histogram->sum += value;
+    ++histogram->buckets[histogram_bucket(value)];
+}
+
+double pl_histogram_bucket_limit(int bucket)
+{
+    int octave = bucket / PL_HISTOGRAM_SUB_BUCKETS;
+    int sub = bucket % PL_HISTOGRAM_SUB_BUCKETS;
+    return ldexp(1.0 + (double) (sub + 1) / PL_HISTOGRAM_SUB_BUCKETS, octave);
+}
+
+double pl_histogram_percentile(const Histogram* histogram, double fraction)
+{
+    if (!histogram->count) {
+        return 0;
+    }
+    unsigned long rank = (unsigned long) ceil(fraction * histogram->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    unsigned long seen = 0;
+    for (int j = 0; j < PL_HISTOGRAM_BUCKETS; ++j) {
+        seen += histogram->buckets[j];
+        if (seen < rank) {
+            continue;
+        }
+        /* never report anything outside the values we actually saw */
+        double limit = pl_histogram_bucket_limit(j);
+        if (limit > histogram->max) {
+            limit = histogram->max;
+        }
+        if (limit < histogram->min) {
+            limit = histogram->min;
+        }
+        return limit;
+    }
+    return histogram->max;
+}
+
+void pl_stats_init(V8Context* ctx, long sample_rate)
+{
+    ctx->stats_table = new StatsTable;
+    ctx->stats_table->sample_rate = sample_rate > 1 ? sample_rate : 1;
+    pl_stats_reset(ctx);
+}
+
+void pl_stats_free(V8Context* ctx)
+{
+    delete ctx->stats_table;
+    ctx->stats_table = 0;
+}
+
+void pl_stats_reset(V8Context* ctx)
+{
+    StatsTable* table = ctx->stats_table;
+    memset(table->entries, 0, sizeof(table->entries));
+    for (int j = 0; j < PL_STAT_COUNT; ++j) {
+        table->entries[j].countdown = 1;  /* always measure the first call */
+    }
+    table->current = -1;
+    for (int j = 0; j < PL_MONITOR_LEVELS; ++j) {
+        table->memory_pressure[j].store(0);
+    }
+}
+
+void pl_stats_start(pTHX_ V8Context* ctx, Perf* perf, PlStat stat)
+{
+    perf->sampled = false;
     if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
         return;
     }
-    perf->t0 = now_us();
-    perf->m0 = total_memory_pages() * ctx->pagesize_bytes;
+    StatsTable* table = ctx->stats_table;
+    StatsEntry* entry = &table->entries[stat];
+    perf->stat = stat;
+    perf->previous = table->current;
+    table->current = stat;
+    if (--entry->countdown) {
+        return;
+    }
+    entry->countdown = table->sample_rate;
+    perf->sampled = true;
+    perf->t0 = monotonic_us();
+    perf->c0 = thread_cpu_us();
+    perf->m0 = pl_heap_allocated_bytes(ctx);
 }
 
-void pl_stats_stop(pTHX_ V8Context* ctx, Perf* perf, const char* name)
+void pl_stats_stop(pTHX_ V8Context* ctx, Perf* perf)
 {
     if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
         return;
     }
-    perf->t1 = now_us();
-    perf->m1 = total_memory_pages() * ctx->pagesize_bytes;
+    PlStat stat = perf->stat;
+    StatsEntry* entry = &ctx->stats_table->entries[stat];
+    ctx->stats_table->current = perf->previous;
+    ++entry->calls;
+    pl_metrics_call(stat);
+    if (!perf->sampled) {
+        return;
+    }
+    perf->t1 = monotonic_us();
+    perf->c1 = thread_cpu_us();
+    perf->m1 = pl_heap_allocated_bytes(ctx);
+
+    /* this can be slightly negative, because of GC accounting */
+    double allocated = perf->m1 - perf->m0;
+    ++entry->samples;
+    entry->elapsed_us = perf->t1 - perf->t0;
+    entry->cpu_us = perf->c1 - perf->c0;
+    entry->memory_bytes = allocated > 0 ? allocated : 0;
+    pl_histogram_add(&entry->elapsed, entry->elapsed_us);
+    pl_metrics_observe(stat, entry->elapsed_us);
+}
+
+double pl_stats_timer_start(V8Context* ctx)
+{
+    if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
+        return 0;
+    }
+    return monotonic_us();
+}
+
+void pl_stats_timer_stop(V8Context* ctx, PlStat stat, double t0)
+{
+    if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
+        return;
+    }
+    pl_stats_record(ctx, stat, monotonic_us() - t0);
+}
+
+void pl_stats_record(V8Context* ctx, PlStat stat, double elapsed_us)
+{
+    StatsEntry* entry = &ctx->stats_table->entries[stat];
+    ++entry->calls;
+    ++entry->samples;
+    entry->elapsed_us = elapsed_us;
+    pl_histogram_add(&entry->elapsed, elapsed_us);
+    pl_metrics_call(stat);
+    pl_metrics_observe(stat, elapsed_us);
+}
+
+void pl_stats_record_gc(V8Context* ctx, PlStat type, double elapsed_us)
+{
+    StatsTable* table = ctx->stats_table;
+    pl_stats_record(ctx, PL_STAT_GC, elapsed_us);
+    pl_stats_record(ctx, type, elapsed_us);
+    if (table->current >= 0) {
+        StatsEntry* entry = &table->entries[table->current];
+        ++entry->gc_count;
+        entry->gc_us += elapsed_us;
+    }
+}
+
+void pl_stats_record_memory_pressure(V8Context* ctx, int level)
+{
+    ctx->stats_table->memory_pressure[level].fetch_add(1);
+}
+
+void pl_stats_materialize(pTHX_ V8Context* ctx)
+{
+    for (int j = 0; j < PL_MONITOR_LEVELS; ++j) {
+        unsigned long events = ctx->stats_table->memory_pressure[j].load();
+        if (events) {
+            save_stat(aTHX_ ctx, "memory_monitor", pl_monitor_level_name(j), events);
+        }
+    }
+
+    if (!(ctx->flags & V8_OPT_FLAG_GATHER_STATS)) {
+        return;
+    }
+    for (int j = 0; j < PL_STAT_COUNT; ++j) {
+        const StatsEntry* entry = &ctx->stats_table->entries[j];
+        if (!entry->calls) {
+            continue;
+        }
+        const char* name = stat_names[j];
+        const Histogram* elapsed = &entry->elapsed;
+        save_stat(aTHX_ ctx, name, "calls", entry->calls);
+        save_stat(aTHX_ ctx, name, "samples", entry->samples);
+        if (j < PL_STAT_FIRST_TIMER) {
+            save_stat(aTHX_ ctx, name, "gc_count", entry->gc_count);
+            save_stat(aTHX_ ctx, name, "gc_us", entry->gc_us);
+        }
+        if (!entry->samples) {
+            continue;
+        }
+        save_stat(aTHX_ ctx, name, "elapsed_us", entry->elapsed_us);
+        save_stat(aTHX_ ctx, name, "elapsed_us_count", elapsed->count);
+        save_stat(aTHX_ ctx, name, "elapsed_us_sum", elapsed->sum);
+        save_stat(aTHX_ ctx, name, "elapsed_us_min", elapsed->min);
+        save_stat(aTHX_ ctx, name, "elapsed_us_max", elapsed->max);
+        save_stat(aTHX_ ctx, name, "elapsed_us_p50", pl_histogram_percentile(elapsed, 0.50));
+        save_stat(aTHX_ ctx, name, "elapsed_us_p90", pl_histogram_percentile(elapsed, 0.90));
+        save_stat(aTHX_ ctx, name, "elapsed_us_p99", pl_histogram_percentile(elapsed, 0.99));
+        save_stat(aTHX_ ctx, name, "elapsed_us_p999", pl_histogram_percentile(elapsed, 0.999));
+        if (j >= PL_STAT_FIRST_TIMER) {
+            continue;
+        }
+        save_stat(aTHX_ ctx, name, "cpu_us", entry->cpu_us);
+        save_stat(aTHX_ ctx, name, "memory_bytes", entry->memory_bytes);
+    }
+}
 
-    save_stat(aTHX_ ctx, name, "elapsed_us", perf->t1 - perf->t0);
-    save_stat(aTHX_ ctx, name, "memory_bytes", perf->m1 - perf->m0);
+void pl_stats_add(pTHX_ V8Context* ctx, const char* category, const char* name, double value)
+{
+    save_stat(aTHX_ ctx, category, name, value, true);
 }
@@ -1,15 +1,163 @@
 #ifndef PL_STATS_H
 #define PL_STATS_H
 
+#include <atomic>
 #include "V8Context.h"
+#include "pl_monitor.h"
 #include "ppport.h"
 
+/*
+ * All the operations we gather stats for; the names used when returning the
+ * stats to Perl are in the same order, in pl_stats.cc.
+ */
+enum PlStat {
+    PL_STAT_COMPILE,
+    PL_STAT_RUN,
+    PL_STAT_GET,
+    PL_STAT_GET_MANY,
+    PL_STAT_EXISTS,
+    PL_STAT_TYPEOF,
+    PL_STAT_INSTANCEOF,
+    PL_STAT_SET,
+    PL_STAT_SET_MANY,
+    PL_STAT_SET_LAZY,
+    PL_STAT_SET_PERSISTENT,
+    PL_STAT_SYNC,
+    PL_STAT_BIND,
+    PL_STAT_BIND_SCALAR,
+    PL_STAT_REMOVE,
+    PL_STAT_DISPATCH,
+    PL_STAT_GLOBAL_OBJECTS,
+    PL_STAT_RUN_GC,
+    PL_STAT_IDLE_GC,
+    PL_STAT_MEMORY_PRESSURE,
+    PL_STAT_START_PROFILING,
+    PL_STAT_STOP_PROFILING,
+
+    /* these are timed on their own, while running one of the above */
+    PL_STAT_CONVERT,
+    PL_STAT_CALLBACK,
+    PL_STAT_GC,
+
+    /* garbage collections, by type */
+    PL_STAT_GC_SCAVENGE,
+    PL_STAT_GC_MARK_COMPACT,
+    PL_STAT_GC_INCREMENTAL,
+    PL_STAT_GC_WEAK_CALLBACKS,
+
+    PL_STAT_COUNT
+};
+
+#define PL_STAT_FIRST_TIMER PL_STAT_CONVERT
+
+/* Return the name for an operation, as used when returning stats to Perl */
+const char* pl_stats_name(PlStat stat);
+
 struct Perf {
-    double t0, t1;
-    double m0, m1;
+    PlStat stat;
+    int previous;   /* operation that was running when this one started */
+    bool sampled;
+    double t0, t1;  /* monotonic clock */
+    double c0, c1;  /* thread CPU time */
+    double m0, m1;  /* bytes allocated in the V8 heap */
 };
 
-void pl_stats_start(pTHX_ V8Context* ctx, Perf* perf);
-void pl_stats_stop(pTHX_ V8Context* ctx, Perf* perf, const char* name);
+/*
+ * A log-bucketed latency histogram, in the spirit of HdrHistogram: each power
+ * of two (in microseconds) is split into PL_HISTOGRAM_SUB_BUCKETS linear
+ * buckets, so any percentile is reported with a relative error of at most
+ * 1 / PL_HISTOGRAM_SUB_BUCKETS, using a small fixed amount of memory.
+ */
+#define PL_HISTOGRAM_SUB_BUCKETS 8
+#define PL_HISTOGRAM_OCTAVES    36  /* up to 2^36 us, about 19 hours */
+#define PL_HISTOGRAM_BUCKETS    (PL_HISTOGRAM_SUB_BUCKETS * PL_HISTOGRAM_OCTAVES)
+
+struct Histogram {
+    unsigned long count;
+    double sum;
+    double min;
+    double max;
+    unsigned int buckets[PL_HISTOGRAM_BUCKETS];
+};
+
+void pl_histogram_add(Histogram* histogram, double value);
+
+/* Return the value below which the given fraction (0 to 1) of values lie */
+double pl_histogram_percentile(const Histogram* histogram, double fraction);
+
+/* Return the upper bound of the values counted in a given bucket */
+double pl_histogram_bucket_limit(int bucket);
+
+/*
+ * The stats for each operation are kept in a fixed array in the context; on
+ * each call we just update a few numbers there, and only build the Perl data
+ * when the stats are requested.  Optionally, only 1 in every sample_rate calls
+ * to each operation is measured; all calls are counted anyway.
+ */
+struct StatsEntry {
+    unsigned long calls;    /* number of calls */
+    unsigned long samples;  /* number of measured calls */
+    unsigned long countdown;  /* calls until the next measured one */
+    double elapsed_us;      /* for the last measured call */
+    double cpu_us;          /* for the last measured call */
+    double memory_bytes;    /* for the last measured call */
+    Histogram elapsed;      /* for all measured calls */
+    unsigned long gc_count; /* GCs that happened while running this operation */
+    double gc_us;           /* time spent in those GCs */
+};
+
+struct StatsTable {
+    StatsEntry entries[PL_STAT_COUNT];
+    unsigned long sample_rate;
+    int current;              /* operation running right now, or -1 */
+
+    /* updated from the memory monitor thread */
+    std::atomic<unsigned long> memory_pressure[PL_MONITOR_LEVELS];
+};
+
+void pl_stats_init(V8Context* ctx, long sample_rate);
+void pl_stats_free(V8Context* ctx);
+void pl_stats_reset(V8Context* ctx);
+
+void pl_stats_start(pTHX_ V8Context* ctx, Perf* perf, PlStat stat);
+void pl_stats_stop(pTHX_ V8Context* ctx, Perf* perf);
+
+/*
+ * Time something that happens while running an operation, such as converting
+ * data or calling back into Perl; pl_stats_timer_start returns 0 when the
+ * context does not gather stats.
+ */
+double pl_stats_timer_start(V8Context* ctx);
+void pl_stats_timer_stop(V8Context* ctx, PlStat stat, double t0);
+
+/*
+ * Record an event that was already timed, for example a GC.
+ */
+void pl_stats_record(V8Context* ctx, PlStat stat, double elapsed_us);
+
+/*
+ * Record a garbage collection of a given type (one of the PL_STAT_GC_*
+ * values); it is also added to the totals for all GCs, and charged to the
+ * operation that was running when it happened, if any.
+ */
+void pl_stats_record_gc(V8Context* ctx, PlStat type, double elapsed_us);
+
+/*
+ * Record that the memory monitor sent a memory pressure level to the isolate
+ * for a context; this is always recorded, and it is safe to call from any
+ * thread.
+ */
+void pl_stats_record_memory_pressure(V8Context* ctx, int level);
+
+/*
+ * Store the stats for all operations into the stats hash for the context.
+ */
+void pl_stats_materialize(pTHX_ V8Context* ctx);
+
+/*
+ * Add a value to a stat, for events that are always recorded (even if the
+ * context does not gather stats), such as recycling its isolate.
+ */
+void pl_stats_add(pTHX_ V8Context* ctx, const char* category, const char* name, double value);
 
 #endif
@@ -0,0 +1,286 @@
+#include <string.h>
+#include <map>
+#include <string>
+#include "pl_v8.h"
+#include "pl_bind.h"
+#include "pl_sync.h"
+#include "V8Context.h"
+#include "ppport.h"
+
+struct SyncData {
+    SyncData(V8Context* ctx, SV* container, const char* root) :
+        ctx(ctx), container(SvREFCNT_inc(container)), root(root), generation(0) {}
+
+    V8Context* ctx;
+    SV* container;              /* the HV / AV, kept alive while we map it */
+    std::string root;           /* name passed to the sync call that reached it */
+    unsigned long generation;   /* last sync pass that reached it */
+    Persistent<Object> handle;  /* weak handle to the JS object */
+};
+
+/* All live mappings, keyed by context and Perl container. */
+typedef std::pair<V8Context*, void*> SyncKey;
+typedef std::map<SyncKey, SyncData*> SyncMap;
+static SyncMap sync_map;
+
+static void sync_data_release(const WeakCallbackInfo<SyncData>& info)
+{
+    dTHX;
+    SyncData* data = info.GetParameter();
+    SvREFCNT_dec(data->container);
+    delete data;
+}
+
+static void sync_data_weak(const WeakCallbackInfo<SyncData>& info)
+{
+    SyncData* data = info.GetParameter();
+    sync_map.erase(SyncKey(data->ctx, data->container));
+    data->handle.Reset();
+
+    /* releasing the Perl data can run arbitrary Perl code; do it after GC */
+    info.SetSecondPassCallback(sync_data_release);
+}
+
+static void sync_data_free(pTHX_ SyncData* data)
+{
+    data->handle.Reset();
+    SvREFCNT_dec(data->container);
+    delete data;
+}
+
+static Local<Value> sync_value(pTHX_ V8Context* ctx, Local<Context>& context, SV* value, const char* root, unsigned long generation);
+
+/*
+ * Return true if a plain Perl scalar would convert to a JS value equal to the
+ * current one, so that we do not have to create a new JS value just to find
+ * out it did not change.  This follows the rules in pl_perl_to_v8; anything
+ * that is not obviously equal counts as changed.
+ */
+static bool same_leaf(pTHX_ V8Context* ctx, SV* value, const Local<Value>& current)
+{
+    if (!value) {
+        return current->IsNull();
+    }
+    if (SvROK(value) || SvGMAGICAL(value)) {
+        return false;
+    }
+    if (!SvOK(value)) {
+        return current->IsNull();
+    }
+    if (SvPOK(value)) {
+        if (!current->IsString()) {
+            return false;
+        }
+        STRLEN vlen = 0;
+        const char* vstr = SvPV_const(value, vlen);
+        Local<String> str = Local<String>::Cast(current);
+        if ((STRLEN) str->Utf8Length(ctx->isolate) != vlen) {
+            return false;
+        }
+        String::Utf8Value cur(ctx->isolate, str);
+        return (STRLEN) cur.length() == vlen && memcmp(*cur, vstr, vlen) == 0;
+    }
+    if (SvIOK(value)) {
+        return current->IsNumber() && Local<Number>::Cast(current)->Value() == (double) SvIV(value);
+    }
+    if (SvNOK(value)) {
+        return current->IsNumber() && Local<Number>::Cast(current)->Value() == SvNV(value);
+    }
+    return false;
+}
+
+/*
+ * Write a Perl value into a slot, but only if it changed.  On failure, record
+ * the error with pl_fail and return false.
+ */
+static bool sync_slot(pTHX_ V8Context* ctx, Local<Context>& context, const Local<Object>& object, const Local<Value>& key, SV* value, bool fresh, const char* root, unsigned long generation)
+{
+    Local<Value> current;
+    if (!fresh) {
+        if (!object->Get(context, key).ToLocal(&current)) {
+            pl_fail(aTHX_ ctx, "Could not get JS element while syncing\n");
+            return false;
+        }
+        if (same_leaf(aTHX_ ctx, value, current)) {
+            return true;
+        }
+    }
+    Local<Value> nested = value
+                        ? sync_value(aTHX_ ctx, context, value, root, generation)
+                        : Local<Value>::Cast(Null(ctx->isolate));
+    if (nested.IsEmpty()) {
+        return false;
+    }
+    if (!current.IsEmpty() && current->StrictEquals(nested)) {
+        return true;
+    }
+    if (!object->Set(context, key, nested).FromMaybe(false)) {
+        pl_fail(aTHX_ ctx, "Could not set JS element while syncing\n");
+        return false;
+    }
+    return true;
+}
+
+static bool sync_hash(pTHX_ V8Context* ctx, Local<Context>& context, HV* values, const Local<Object>& object, bool fresh, const char* root, unsigned long generation)
+{
+    hv_iterinit(values);
+    while (1) {
+        HE* entry = hv_iternext(values);
+        if (!entry) {
+            break; /* no more hash keys */
+        }
+        SV* key = hv_iterkeysv(entry);
+        if (!key) {
+            continue; /* invalid key */
+        }
+        SV* value = hv_iterval(values, entry);
+        if (!value) {
+            continue; /* invalid value */
+        }
+        STRLEN klen = 0;
+        const char* kstr = SvPVutf8(key, klen);
+        Local<Value> v8_key = String::NewFromUtf8(ctx->isolate, kstr, NewStringType::kNormal, klen).ToLocalChecked();
+        if (!sync_slot(aTHX_ ctx, context, object, v8_key, value, fresh, root, generation)) {
+            return false;
+        }
+    }
+    if (fresh) {
+        return true;
+    }
+
+    /* remove any keys that are no longer in the Perl hash */
+    Local<Array> property_names;
+    if (!object->GetOwnPropertyNames(context).ToLocal(&property_names)) {
+        pl_fail(aTHX_ ctx, "Could not get object keys while syncing\n");
+        return false;
+    }
+    int hash_top = property_names->Length();
+    for (int j = 0; j < hash_top; ++j) {
+        Local<Value> v8_key;
+        if (!property_names->Get(context, j).ToLocal(&v8_key)) {
+            pl_fail(aTHX_ ctx, "Could not get object key while syncing\n");
+            return false;
+        }
+        String::Utf8Value key(ctx->isolate, v8_key);
+        if (hv_exists(values, *key, -key.length())) {
+            continue;
+        }
+        if (!object->Delete(context, v8_key).FromMaybe(false)) {
+            pl_fail(aTHX_ ctx, "Could not delete JS element while syncing\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sync_array(pTHX_ V8Context* ctx, Local<Context>& context, AV* values, const Local<Object>& object, bool fresh, const char* root, unsigned long generation)
+{
+    Local<Array> array = Local<Array>::Cast(object);
+    int array_top = av_top_index(values) + 1;
+    for (int j = 0; j < array_top; ++j) {
+        SV** elem = av_fetch(values, j, 0);
+        SV* value = elem && *elem ? *elem : 0;
+        if (!sync_slot(aTHX_ ctx, context, array, Integer::New(ctx->isolate, j), value, fresh, root, generation)) {
+            return false;
+        }
+    }
+
+    /* truncate the JS array if the Perl array shrank */
+    if (!fresh && array->Length() > (uint32_t) array_top) {
+        Local<Value> v8_key = String::NewFromUtf8(ctx->isolate, "length", NewStringType::kNormal).ToLocalChecked();
+        if (!array->Set(context, v8_key, Integer::New(ctx->isolate, array_top)).FromMaybe(false)) {
+            pl_fail(aTHX_ ctx, "Could not truncate JS array while syncing\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static Local<Value> sync_value(pTHX_ V8Context* ctx, Local<Context>& context, SV* value, const char* root, unsigned long generation)
+{
+    SV* container = SvROK(value) ? SvRV(value) : 0;
+    int type = container ? SvTYPE(container) : SVt_NULL;
+    if ((type != SVt_PVHV && type != SVt_PVAV) || pl_bind_is_registered_object(aTHX_ ctx, value)) {
+        /* not a container: convert it as usual */
+        return pl_perl_to_v8(aTHX_ value, ctx);
+    }
+
+    SyncKey key(ctx, container);
+    SyncMap::iterator k = sync_map.find(key);
+    SyncData* data = k == sync_map.end() ? 0 : k->second;
+    if (data && data->generation == generation) {
+        /* already synced in this pass (shared or cyclic data) */
+        return Local<Object>::New(ctx->isolate, data->handle);
+    }
+
+    bool fresh = false;
+    Local<Object> object;
+    if (data) {
+        object = Local<Object>::New(ctx->isolate, data->handle);
+    } else {
+        fresh = true;
+        if (type == SVt_PVAV) {
+            object = Array::New(ctx->isolate);
+        } else {
+            object = Object::New(ctx->isolate);
+        }
+        data = new SyncData(ctx, container, root);
+        data->handle.Reset(ctx->isolate, object);
+        data->handle.SetWeak(data, sync_data_weak, WeakCallbackType::kParameter);
+        sync_map[key] = data;
+    }
+    data->generation = generation;
+    data->root = root;
+
+    bool ok = type == SVt_PVAV
+            ? sync_array(aTHX_ ctx, context, (AV*) container, object, fresh, root, generation)
+            : sync_hash(aTHX_ ctx, context, (HV*) container, object, fresh, root, generation);
+    return ok ? Local<Value>::Cast(object) : Local<Value>();
+}
+
+int pl_sync_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value)
+{
+    int ret = 0;
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    Local<Object> parent;
+    Local<Value> slot;
+    bool found = find_parent(ctx, name, context, parent, slot);
+    if (found) {
+        /* JS code (setters, proxies, frozen objects) can make a pass fail */
+        TryCatch try_catch(ctx->isolate);
+        unsigned long generation = ++ctx->sync_generation;
+        if (!sync_slot(aTHX_ ctx, context, parent, slot, value, false, name, generation)) {
+            /* V8Context croaks once out of V8; keep the mappings for next time */
+            return 0;
+        }
+
+        /* forget containers for this name that were not reached in this pass */
+        SyncMap::iterator k = sync_map.lower_bound(SyncKey(ctx, 0));
+        while (k != sync_map.end() && k->first.first == ctx) {
+            SyncData* data = k->second;
+            if (data->generation == generation || data->root != name) {
+                ++k;
+                continue;
+            }
+            sync_map.erase(k++);
+            sync_data_free(aTHX_ data);
+        }
+        ret = 1;
+    }
+
+    return ret;
+}
+
+void pl_sync_tear_down(pTHX_ V8Context* ctx)
+{
+    SyncMap::iterator k = sync_map.lower_bound(SyncKey(ctx, 0));
+    while (k != sync_map.end() && k->first.first == ctx) {
+        SyncData* data = k->second;
+        sync_map.erase(k++);
+        sync_data_free(aTHX_ data);
+    }
+}
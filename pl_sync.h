@@ -0,0 +1,35 @@
+#ifndef PL_SYNC_H
+#define PL_SYNC_H
+
+#include <v8.h>
+#include "pl_config.h"
+#include "ppport.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Incrementally synchronize Perl data into a global / nested property.
+ *
+ * The first time a Perl hash / array is synced, an equivalent JS object /
+ * array is created, just like pl_set_global_or_property would do; we also
+ * remember the mapping from the Perl container to the JS object, in a table
+ * keyed by the address of the HV / AV and holding a weak handle to the JS
+ * object.  On later calls, the same JS objects are reused and only the keys /
+ * elements whose values changed are written, so the identity of unchanged
+ * parts of the JS object graph is preserved and no garbage is created for
+ * them: plain scalars are compared against the current JS value before being
+ * converted.  Each sync pass has a generation number; containers that were
+ * not reached in the latest pass for a name are forgotten.
+ *
+ * JS code can make a pass fail (a setter that throws, a frozen object); the
+ * error is recorded with pl_fail and the pass stops there.
+ */
+int pl_sync_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value);
+
+/*
+ * Forget about all the mappings created for a context.
+ */
+void pl_sync_tear_down(pTHX_ V8Context* ctx);
+
+#endif
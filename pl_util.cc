@@ -1,5 +1,10 @@
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <time.h>
 #include "pl_util.h"
 
 #define FILE_MEMORY_STATUS "/proc/self/statm"
@@ -15,6 +20,27 @@ double now_us(void)
     return now;
 }
 
+static double clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    double now = 0.0;
+    int rc = clock_gettime(clock, &ts);
+    if (rc == 0) {
+        now = 1000000.0 * ts.tv_sec + ts.tv_nsec / 1000.0;
+    }
+    return now;
+}
+
+double monotonic_us(void)
+{
+    return clock_us(CLOCK_MONOTONIC);
+}
+
+double thread_cpu_us(void)
+{
+    return clock_us(CLOCK_THREAD_CPUTIME_ID);
+}
+
 long total_memory_pages(void)
 {
     long pages = 0;
@@ -55,3 +81,36 @@ long total_memory_pages(void)
     }
     return pages;
 }
+
+const char* map_file(const char* path, size_t* size)
+{
+    void* data = MAP_FAILED;
+    int fd = open(path, O_RDONLY);
+    do {
+        struct stat st;
+        if (fd < 0) {
+            break;
+        }
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            break;
+        }
+        data = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            break;
+        }
+        *size = st.st_size;
+    } while (0);
+    if (fd >= 0) {
+        /* the mapping stays valid after closing the file */
+        close(fd);
+    }
+    return data == MAP_FAILED ? 0 : (const char*) data;
+}
+
+void unmap_file(const char* data, size_t size)
+{
+    if (!data) {
+        return;
+    }
+    munmap((void*) data, size);
+}
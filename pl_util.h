@@ -1,12 +1,30 @@
 #ifndef PL_UTIL_H_
 #define PL_UTIL_H_
 
+#include <stddef.h>
+
 #define UNUSED_ARG(x) (void) x
 
 /* Get 'now' timestamp (microseconds since 1970) */
 double now_us(void);
 
+/* Get a monotonic timestamp in microseconds, for measuring elapsed time */
+double monotonic_us(void);
+
+/* Get the CPU time used by the current thread, in microseconds */
+double thread_cpu_us(void);
+
 /* Get how many memory pages are currently in use */
 long total_memory_pages(void);
 
+/*
+ * Map a whole file in memory, read-only and shared, so that all the processes
+ * that map it (for example, forked workers) use the same physical pages.
+ * Return 0 if the file cannot be mapped; otherwise store its size in size.
+ */
+const char* map_file(const char* path, size_t* size);
+
+/* Unmap a file previously mapped with map_file */
+void unmap_file(const char* data, size_t size);
+
 #endif
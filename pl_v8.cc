@@ -1,6 +1,9 @@
 #include <map>
+#include <set>
+#include <string>
 #include "pl_stats.h"
 #include "pl_console.h"
+#include "pl_bind.h"
 #include "pl_v8.h"
 
 #define NEED_sv_2pv_flags_GLOBAL
@@ -36,6 +39,27 @@ typedef std::map<void*, Local<Object>> MapP2J;
 /* maps from JavaScript to Perl -- Object* to SV* */
 typedef std::map<Local<Object>, void*, LocalObjectCompare> MapJ2P;
 
+/*
+ * State for one conversion from JavaScript to Perl: the objects seen so far,
+ * the options requested by the caller and how much we have converted, so we
+ * can enforce the conversion limits of the context.
+ */
+struct ConvState {
+    ConvState(V8Context* ctx, const ConvOpts* opts) :
+        ctx(ctx), opts(opts), nodes(0), bytes(0),
+        max_nodes(ctx->max_convert_nodes), max_bytes(ctx->max_convert_bytes),
+        failed(false) {}
+
+    V8Context* ctx;
+    MapJ2P seen;
+    const ConvOpts* opts;
+    long nodes;
+    long bytes;
+    long max_nodes;
+    long max_bytes;
+    bool failed;  /* went over the limits; the error was recorded with pl_fail */
+};
+
 struct FuncData {
     FuncData(V8Context* ctx, SV* func) :
         ctx(ctx), func(newSVsv(func)) {}
@@ -44,8 +68,75 @@ struct FuncData {
     SV* func;
 };
 
+struct LazyData {
+    LazyData(V8Context* ctx, SV* func) :
+        ctx(ctx), func(newSVsv(func)) {}
+
+    V8Context* ctx;
+    SV* func;
+};
+
+/*
+ * Lazy properties that have not been materialized yet, so we can release
+ * them when a context is torn down.
+ */
+typedef std::pair<V8Context*, LazyData*> LazyKey;
+typedef std::set<LazyKey> LazySet;
+static LazySet lazy_set;
+
+#define PL_CONV_OPT_FIELDS  "fields"
+#define PL_CONV_OPT_DEPTH   "depth"
+#define PL_CONV_OPT_SLICE   "slice"
+
 static const char* get_typeof(const Local<Object>& object);
 
+static SV* pl_vfail(pTHX_ V8Context* ctx, const char* fmt, va_list* args)
+{
+    SV* error = vnewSVpvf(fmt, args);
+    if (ctx->pending_error) {
+        SvREFCNT_dec(error);
+    } else {
+        ctx->pending_error = error;
+    }
+    return ctx->pending_error;
+}
+
+void pl_fail(pTHX_ V8Context* ctx, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    pl_vfail(aTHX_ ctx, fmt, &args);
+    va_end(args);
+}
+
+static void throw_in_js(pTHX_ V8Context* ctx, SV* error, bool type_error)
+{
+    STRLEN elen = 0;
+    const char* estr = SvPV_const(error, elen);
+    Local<String> message;
+    if (String::NewFromUtf8(ctx->isolate, estr, NewStringType::kNormal, elen).ToLocal(&message)) {
+        ctx->isolate->ThrowException(type_error ? Exception::TypeError(message) : Exception::Error(message));
+    }
+}
+
+void pl_fail_in_js(pTHX_ V8Context* ctx, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    SV* error = pl_vfail(aTHX_ ctx, fmt, &args);
+    va_end(args);
+    throw_in_js(aTHX_ ctx, error, false);
+}
+
+void pl_type_fail_in_js(pTHX_ V8Context* ctx, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    SV* error = pl_vfail(aTHX_ ctx, fmt, &args);
+    va_end(args);
+    throw_in_js(aTHX_ ctx, error, true);
+}
+
 static void perl_caller(const FunctionCallbackInfo<Value>& args)
 {
     Isolate* isolate = args.GetIsolate();
@@ -89,19 +180,21 @@ static void perl_caller(const FunctionCallbackInfo<Value>& args)
 
     /* call actual Perl CV, passing all params */
     PUTBACK;
+    double t0 = pl_stats_timer_start(data->ctx);
     call_sv(data->func, G_SCALAR | G_EVAL);
+    pl_stats_timer_stop(data->ctx, PL_STAT_CALLBACK, t0);
     SPAGAIN;
 
+    /* get returned value from Perl and return it, unless the sub died */
+    ret = POPs;
     err_tmp = ERRSV;
     if (SvTRUE(err_tmp)) {
-        croak("Perl sub died with error: %s", SvPV_nolen(err_tmp));
+        pl_fail_in_js(aTHX_ data->ctx, "Perl sub died with error: %s", SvPV_nolen(err_tmp));
+    }
+    else {
+        Local<Object> object = pl_perl_to_v8(aTHX_ ret, data->ctx);
+        args.GetReturnValue().Set(object);
     }
-
-    /* get returned value from Perl and return it */
-    ret = POPs;
-    Local<Object> object = pl_perl_to_v8(aTHX_ ret, data->ctx);
-
-    args.GetReturnValue().Set(object);
 
     /* cleanup */
     PUTBACK;
@@ -109,10 +202,72 @@ static void perl_caller(const FunctionCallbackInfo<Value>& args)
     LEAVE;
 }
 
-static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object, MapJ2P& seen)
+/*
+ * Get the names of the properties we will convert for an object: all of its
+ * own properties, or only those requested (and present) when projecting.
+ */
+static Local<Array> get_property_names(pTHX_ V8Context* ctx, Local<Context>& context, const Local<Object>& object, const ConvOpts* opts, int level)
+{
+    int fields_level = opts && opts->fields ? opts->fields_level : -1;
+    if (level != fields_level) {
+        return object->GetOwnPropertyNames(context).ToLocalChecked();
+    }
+
+    Local<Array> names = Array::New(ctx->isolate);
+    int count = 0;
+    int fields_top = av_top_index(opts->fields) + 1;
+    for (int j = 0; j < fields_top; ++j) {
+        SV** elem = av_fetch(opts->fields, j, 0);
+        if (!elem || !*elem) {
+            continue;
+        }
+        STRLEN flen = 0;
+        const char* fstr = SvPVutf8(*elem, flen);
+        Local<String> v8_key = String::NewFromUtf8(ctx->isolate, fstr, NewStringType::kNormal, flen).ToLocalChecked();
+        if (!object->HasOwnProperty(context, v8_key).FromMaybe(false)) {
+            continue; /* only own properties, as without projection */
+        }
+        if (!names->Set(context, count++, v8_key).IsJust()) {
+            /* V8Context croaks with this once out of V8 */
+            pl_fail(aTHX_ ctx, "Could not set field name\n");
+            break;
+        }
+    }
+    return names;
+}
+
+/*
+ * Account for converted values and string bytes; return false when over the
+ * limits, so that the conversion stops as soon as possible.  Callers charge
+ * the bytes of a string before copying it.
+ */
+static bool charge_conversion(pTHX_ ConvState& state, long nodes, long bytes)
+{
+    if (state.failed) {
+        return false;
+    }
+    state.nodes += nodes;
+    state.bytes += bytes;
+    if (state.max_nodes > 0 && state.nodes > state.max_nodes) {
+        pl_fail(aTHX_ state.ctx, "Conversion to Perl exceeded maximum of %ld nodes\n", state.max_nodes);
+        state.failed = true;
+    }
+    else if (state.max_bytes > 0 && state.bytes > state.max_bytes) {
+        pl_fail(aTHX_ state.ctx, "Conversion to Perl exceeded maximum of %ld bytes\n", state.max_bytes);
+        state.failed = true;
+    }
+    return !state.failed;
+}
+
+static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object, ConvState& state, int level)
 {
     SV* ret = &PL_sv_undef; /* return undef by default */
     Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    const ConvOpts* opts = state.opts;
+    MapJ2P& seen = state.seen;
+    if (!charge_conversion(aTHX_ state, 1, 0)) {
+        return ret;
+    }
     if (object->IsUndefined()) {
     }
     else if (object->IsNull()) {
@@ -129,9 +284,12 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
         ret = newSVnv(val);  /* JS numbers are always doubles */
     }
     else if (object->IsString()) {
-        String::Utf8Value val(ctx->isolate, object);
-        ret = newSVpvn(*val, val.length());
-        SvUTF8_on(ret); /* yes, always */
+        long vlen = Local<String>::Cast(object)->Utf8Length(ctx->isolate);
+        if (charge_conversion(aTHX_ state, 0, vlen)) {
+            String::Utf8Value val(ctx->isolate, object);
+            ret = newSVpvn(*val, val.length());
+            SvUTF8_on(ret); /* yes, always */
+        }
     }
     else if (object->IsFunction()) {
         Local<Name> v8_key = String::NewFromUtf8(ctx->isolate, "__perl_callback", NewStringType::kNormal).ToLocalChecked();
@@ -144,6 +302,13 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
             }
         }
     }
+    else if (pl_bind_is_wrapper(object)) {
+        /* a wrapper for Perl data: return the data itself */
+        ret = pl_bind_unwrap(aTHX_ ctx, object);
+    }
+    else if (opts && opts->depth >= 0 && level >= opts->depth && object->IsObject()) {
+        /* too deep, leave it as undef */
+    }
     else if (object->IsArray()) {
         MapJ2P::iterator k = seen.find(object);
         if (k != seen.end()) {
@@ -157,8 +322,19 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
             seen[object] = values;
 
             Local<Array> array = Local<Array>::Cast(object);
-            int array_top = array->Length();
-            for (int j = 0; j < array_top; ++j) {
+            long array_top = array->Length();
+            long array_pos = 0;
+            if (opts && level == 0) {
+                /* only convert the requested slice of the top-level array */
+                array_pos = opts->offset < 0 ? array_top + opts->offset : opts->offset;
+                if (array_pos < 0) {
+                    array_pos = 0;
+                }
+                if (opts->count >= 0 && array_pos + opts->count < array_top) {
+                    array_top = array_pos + opts->count;
+                }
+            }
+            for (long j = array_pos; j < array_top; ++j) {
                 Local<Value> value;
                 if (!array->Get(context, j).ToLocal(&value)) {
                     croak("Could not get array element\n");
@@ -166,13 +342,16 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
                 Local<Object> elem = Local<Object>::Cast(value);
                 /* TODO: check we got a valid element */
 
-                SV* nested = sv_2mortal(pl_v8_to_perl_impl(aTHX_ ctx, elem, seen));
+                SV* nested = sv_2mortal(pl_v8_to_perl_impl(aTHX_ ctx, elem, state, level + 1));
                 if (!nested) {
                     croak("Could not create Perl SV for array\n");
                 }
-                if (av_store(values_array, j, nested)) {
+                if (av_store(values_array, j - array_pos, nested)) {
                     SvREFCNT_inc(nested);
                 }
+                if (state.failed) {
+                    break;
+                }
             }
         }
     }
@@ -188,7 +367,7 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
             ret = newRV_inc(values);
             seen[object] = values;
 
-            Local<Array> property_names = object->GetOwnPropertyNames(context).ToLocalChecked();
+            Local<Array> property_names = get_property_names(aTHX_ ctx, context, object, opts, level);
             int hash_top = property_names->Length();
             for (int j = 0; j < hash_top; ++j) {
                 Local<Value> v8_key;
@@ -196,7 +375,11 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
                     croak("Could not get object key\n");
                 }
 
-                String::Utf8Value key(ctx->isolate, v8_key->ToString(context).ToLocalChecked());
+                Local<String> v8_key_str = v8_key->ToString(context).ToLocalChecked();
+                if (!charge_conversion(aTHX_ state, 0, v8_key_str->Utf8Length(ctx->isolate))) {
+                    break;
+                }
+                String::Utf8Value key(ctx->isolate, v8_key_str);
                 Local<Value> value;
                 if (!object->Get(context, v8_key).ToLocal(&value)) {
                     croak("Could not get object value key\n");
@@ -205,7 +388,7 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
                 Local<Object> obj = Local<Object>::Cast(value);
                 /* TODO: check we got a valid object */
 
-                SV* nested = sv_2mortal(pl_v8_to_perl_impl(aTHX_ ctx, obj, seen));
+                SV* nested = sv_2mortal(pl_v8_to_perl_impl(aTHX_ ctx, obj, state, level + 1));
                 if (!nested) {
                     croak("Could not create Perl SV for hash\n");
                 }
@@ -216,6 +399,9 @@ static SV* pl_v8_to_perl_impl(pTHX_ V8Context* ctx, const Local<Object>& object,
                 if (hv_store(values_hash, kstr, -klen, nested, 0)) {
                     SvREFCNT_inc(nested);
                 }
+                if (state.failed) {
+                    break;
+                }
             }
         }
     }
@@ -254,6 +440,8 @@ static const Local<Object> pl_perl_to_v8_impl(pTHX_ SV* value, V8Context* ctx, M
     } else if (SvNOK(value)) {
         double val = SvNV(value);
         ret = Local<Object>::Cast(Number::New(ctx->isolate, val));
+    } else if (SvROK(value) && pl_bind_is_registered_object(aTHX_ ctx, value)) {
+        ret = pl_bind_wrap(aTHX_ ctx, value);
     } else if (SvROK(value)) {
         SV* ref = SvRV(value);
         int type = SvTYPE(ref);
@@ -348,21 +536,85 @@ static const Local<Object> pl_perl_to_v8_impl(pTHX_ SV* value, V8Context* ctx, M
     return ret;
 }
 
-SV* pl_v8_to_perl(pTHX_ V8Context* ctx, const Local<Object>& object)
+SV* pl_v8_to_perl(pTHX_ V8Context* ctx, const Local<Object>& object, const ConvOpts* opts)
 {
-    MapJ2P seen;
-    SV* ret = pl_v8_to_perl_impl(aTHX_ ctx, object, seen);
+    ConvOpts top;
+    if (opts) {
+        /* fields apply to the top-level object, or to each top-level element */
+        top = *opts;
+        top.fields_level = object->IsArray() ? 1 : 0;
+        opts = &top;
+    }
+    double t0 = pl_stats_timer_start(ctx);
+    ConvState state(ctx, opts);
+    SV* ret = pl_v8_to_perl_impl(aTHX_ ctx, object, state, 0);
+    pl_stats_timer_stop(ctx, PL_STAT_CONVERT, t0);
+    if (state.failed) {
+        /* throw away what we converted before hitting the limits */
+        SvREFCNT_dec(ret);
+        ret = &PL_sv_undef;
+    }
     return ret;
 }
 
+void pl_get_conv_opts(pTHX_ HV* opt, ConvOpts* opts)
+{
+    if (!opt) {
+        return;
+    }
+    hv_iterinit(opt);
+    while (1) {
+        SV* value = 0;
+        I32 klen = 0;
+        char* kstr = 0;
+        HE* entry = hv_iternext(opt);
+        if (!entry) {
+            break; /* no more hash keys */
+        }
+        kstr = hv_iterkey(entry, &klen);
+        if (!kstr || klen < 0) {
+            continue; /* invalid key */
+        }
+        value = hv_iterval(opt, entry);
+        if (!value) {
+            continue; /* invalid value */
+        }
+        if (memcmp(kstr, PL_CONV_OPT_FIELDS, klen) == 0) {
+            if (!SvROK(value) || SvTYPE(SvRV(value)) != SVt_PVAV) {
+                croak("Option %s must be an arrayref\n", PL_CONV_OPT_FIELDS);
+            }
+            opts->fields = (AV*) SvRV(value);
+            continue;
+        }
+        if (memcmp(kstr, PL_CONV_OPT_DEPTH, klen) == 0) {
+            opts->depth = SvIV(value);
+            continue;
+        }
+        if (memcmp(kstr, PL_CONV_OPT_SLICE, klen) == 0) {
+            if (!SvROK(value) || SvTYPE(SvRV(value)) != SVt_PVAV) {
+                croak("Option %s must be an arrayref\n", PL_CONV_OPT_SLICE);
+            }
+            AV* slice = (AV*) SvRV(value);
+            SV** offset = av_fetch(slice, 0, 0);
+            SV** count = av_fetch(slice, 1, 0);
+            opts->offset = offset && SvOK(*offset) ? SvIV(*offset) : 0;
+            opts->count = count && SvOK(*count) ? SvIV(*count) : -1;
+            continue;
+        }
+        croak("Unknown option %*.*s\n", (int) klen, (int) klen, kstr);
+    }
+}
+
 const Local<Object> pl_perl_to_v8(pTHX_ SV* value, V8Context* ctx)
 {
+    double t0 = pl_stats_timer_start(ctx);
     MapP2J seen;
     Local<Object> ret = pl_perl_to_v8_impl(aTHX_ value, ctx, seen, 0);
+    pl_stats_timer_stop(ctx, PL_STAT_CONVERT, t0);
     return ret;
 }
 
-SV* pl_get_global_or_property(pTHX_ V8Context* ctx, const char* name)
+SV* pl_get_global_or_property(pTHX_ V8Context* ctx, const char* name, const ConvOpts* opts)
 {
     SV* ret = &PL_sv_undef; /* return undef by default */
 
@@ -373,7 +625,7 @@ SV* pl_get_global_or_property(pTHX_ V8Context* ctx, const char* name)
     Local<Object> object;
     bool found = find_object(ctx, name, context, object);
     if (found) {
-        ret = pl_v8_to_perl(aTHX_ ctx, object);
+        ret = pl_v8_to_perl(aTHX_ ctx, object, opts);
     }
 
     return ret;
@@ -401,6 +653,182 @@ int pl_set_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value)
     return ret;
 }
 
+static void lazy_data_free(pTHX_ LazyData* data)
+{
+    SvREFCNT_dec(data->func);
+    delete data;
+}
+
+static void lazy_getter(Local<Name> property, const PropertyCallbackInfo<Value>& info)
+{
+    Local<External> v8_val = Local<External>::Cast(info.Data());
+    LazyData* data = (LazyData*) v8_val->Value();
+
+    SV *err_tmp;
+
+    /* prepare Perl environment for calling the CV */
+    dTHX;
+    dSP;
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+
+    /* call actual Perl CV, with no params */
+    PUTBACK;
+    double t0 = pl_stats_timer_start(data->ctx);
+    call_sv(data->func, G_SCALAR | G_EVAL | G_NOARGS);
+    pl_stats_timer_stop(data->ctx, PL_STAT_CALLBACK, t0);
+    SPAGAIN;
+
+    /* V8 replaces the property with the value we return here */
+    SV* ret = POPs;
+    err_tmp = ERRSV;
+    if (SvTRUE(err_tmp)) {
+        pl_fail_in_js(aTHX_ data->ctx, "Perl sub died with error: %s", SvPV_nolen(err_tmp));
+    }
+    else {
+        Local<Object> object = pl_perl_to_v8(aTHX_ ret, data->ctx);
+        info.GetReturnValue().Set(object);
+    }
+
+    /* cleanup */
+    PUTBACK;
+    FREETMPS;
+    LEAVE;
+
+    /*
+     * We cannot free the data here: V8 only replaces the property when the
+     * getter is called on the object itself (not through a different
+     * receiver, as in Reflect.get) and when it does not throw, so it may be
+     * called again; pl_lazy_tear_down frees it.
+     */
+}
+
+int pl_set_lazy_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* func)
+{
+    if (!SvROK(func) || SvTYPE(SvRV(func)) != SVt_PVCV) {
+        /* V8Context croaks with this once out of V8 */
+        pl_fail(aTHX_ ctx, "Lazy value must be a code reference\n");
+        return 0;
+    }
+
+    int ret = 0;
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    Local<Object> parent;
+    Local<Value> slot;
+    bool found = find_parent(ctx, name, context, parent, slot);
+    if (found) {
+        LazyData* data = new LazyData(ctx, func);
+        Local<Value> v8_val = External::New(ctx->isolate, data);
+        Local<Name> v8_name = Local<Name>::Cast(slot);
+        if (!parent->SetLazyDataProperty(context, v8_name, lazy_getter, v8_val).FromMaybe(false)) {
+            lazy_data_free(aTHX_ data);
+            croak("could not set lazy global or property");
+        }
+        lazy_set.insert(LazyKey(ctx, data));
+        ret = 1;
+    }
+
+    return ret;
+}
+
+void pl_lazy_tear_down(pTHX_ V8Context* ctx)
+{
+    LazySet::iterator k = lazy_set.lower_bound(LazyKey(ctx, 0));
+    while (k != lazy_set.end() && k->first == ctx) {
+        LazyData* data = k->second;
+        lazy_set.erase(k++);
+        lazy_data_free(aTHX_ data);
+    }
+}
+
+SV* pl_get_globals_or_properties(pTHX_ V8Context* ctx, AV* names)
+{
+    HV* values = newHV();
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    ConvState state(ctx, 0);
+    int names_top = av_top_index(names) + 1;
+    for (int j = 0; j < names_top; ++j) {
+        SV** elem = av_fetch(names, j, 0);
+        if (!elem || !*elem) {
+            continue;
+        }
+        STRLEN nlen = 0;
+        const char* nstr = SvPV_const(*elem, nlen);
+        SV* value = &PL_sv_undef;
+        Local<Object> object;
+        bool found = find_object(ctx, nstr, context, object);
+        if (found) {
+            /* limits apply to each value, the cache of seen objects is shared */
+            state.nodes = state.bytes = 0;
+            value = pl_v8_to_perl_impl(aTHX_ ctx, object, state, 0);
+            if (state.failed) {
+                /* throw away what we converted before hitting the limits */
+                SvREFCNT_dec(value);
+                SvREFCNT_dec((SV*) values);
+                return &PL_sv_undef;
+            }
+        }
+        SV* pvalue = newSVsv(sv_2mortal(value));
+        if (!hv_store(values, nstr, nlen, pvalue, 0)) {
+            SvREFCNT_dec(pvalue);
+            croak("Could not store value for %s\n", nstr);
+        }
+    }
+
+    return newRV_noinc((SV*) values);
+}
+
+int pl_set_globals_or_properties(pTHX_ V8Context* ctx, HV* values)
+{
+    int ret = 0;
+
+    HandleScope handle_scope(ctx->isolate);
+    Local<Context> context = Local<Context>::New(ctx->isolate, *ctx->persistent_context);
+    Context::Scope context_scope(context);
+
+    MapP2J seen;
+    hv_iterinit(values);
+    while (1) {
+        HE* entry = hv_iternext(values);
+        if (!entry) {
+            break; /* no more hash keys */
+        }
+        I32 klen = 0;
+        char* kstr = hv_iterkey(entry, &klen);
+        if (!kstr || klen < 0) {
+            continue; /* invalid key */
+        }
+        SV* value = hv_iterval(values, entry);
+        if (!value) {
+            continue; /* invalid value */
+        }
+        /* hash keys are not nul-terminated in general */
+        std::string name(kstr, klen);
+        Local<Object> parent;
+        Local<Value> slot;
+        bool found = find_parent(ctx, name.c_str(), context, parent, slot);
+        if (!found) {
+            continue;
+        }
+        Local<Object> object = pl_perl_to_v8_impl(aTHX_ value, ctx, seen, 0);
+        if (!parent->Set(context, slot, object).IsJust()) {
+            croak("could not set global or property %s", name.c_str());
+        }
+        ++ret;
+    }
+
+    return ret;
+}
+
 int pl_del_global_or_property(pTHX_ V8Context* ctx, const char* name)
 {
     int ret = 0;
@@ -513,6 +941,30 @@ int pl_run_gc(V8Context* ctx)
     return PL_GC_RUNS;
 }
 
+int pl_idle_gc(V8Context* ctx, double deadline_in_seconds)
+{
+    return ctx->isolate->IdleNotificationDeadline(deadline_in_seconds) ? 1 : 0;
+}
+
+int pl_memory_pressure_level(const char* name)
+{
+    if (strcmp(name, PL_MEMORY_PRESSURE_NONE) == 0) {
+        return (int) MemoryPressureLevel::kNone;
+    }
+    if (strcmp(name, PL_MEMORY_PRESSURE_MODERATE) == 0) {
+        return (int) MemoryPressureLevel::kModerate;
+    }
+    if (strcmp(name, PL_MEMORY_PRESSURE_CRITICAL) == 0) {
+        return (int) MemoryPressureLevel::kCritical;
+    }
+    return -1;
+}
+
+void pl_memory_pressure(V8Context* ctx, int level)
+{
+    ctx->isolate->MemoryPressureNotification((MemoryPressureLevel) level);
+}
+
 bool find_parent(V8Context* ctx, const char* name, Local<Context>& context, Local<Object>& parent, Local<Value>& slot, int create)
 {
     int start = 0;
@@ -538,7 +990,10 @@ bool find_parent(V8Context* ctx, const char* name, Local<Context>& context, Loca
         if (parent->Has(context, slot).ToChecked()) {
             /* parent has a slot with that name */
             if (!parent->Get(context, slot).ToLocal(&child)) {
-                croak("could not get parent slot");
+                /* a getter threw; croak once we are out of V8 */
+                dTHX;
+                pl_fail(aTHX_ ctx, "could not get parent slot");
+                break;
             }
         }
         else if (!create) {
@@ -548,8 +1003,11 @@ bool find_parent(V8Context* ctx, const char* name, Local<Context>& context, Loca
         else {
             /* create the missing slot and go on */
             child = Object::New(ctx->isolate);
-            if (!parent->Set(context, slot, child).IsJust()) {
-                croak("could not set parent slot");
+            if (!parent->Set(context, slot, child).FromMaybe(false)) {
+                /* a setter threw; croak once we are out of V8 */
+                dTHX;
+                pl_fail(aTHX_ ctx, "could not set parent slot");
+                break;
             }
         }
         parent = Local<Object>::Cast(child);
@@ -577,7 +1035,9 @@ bool find_object(V8Context* ctx, const char* name, Local<Context>& context, Loca
     }
     Local<Value> child;
     if (!parent->Get(context, slot).ToLocal(&child)) {
-        croak("could not get object slot");
+        /* a getter threw; croak once we are out of V8 */
+        dTHX;
+        pl_fail(aTHX_ ctx, "could not get object slot");
         return false;
     }
     object = Local<Object>::Cast(child);
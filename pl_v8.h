@@ -18,6 +18,52 @@ class V8Context;
 #define PL_SLOT_GENERIC_CALLBACK  PL_SLOT_CREATE(PL_NAME_GENERIC_CALLBACK)
 #endif
 
+/*
+ * Options to limit how much of a JS value is converted into Perl data.
+ *
+ * fields: if not null, only convert these keys for the top-level object (or
+ * for each object in the top-level array).
+ *
+ * depth: if not negative, only convert this many levels of nested arrays /
+ * objects; any deeper ones are returned as undef.
+ *
+ * offset / count: only convert this range of elements for the top-level
+ * array; a negative offset counts from the end, and a negative count means
+ * "up to the end".
+ */
+struct ConvOpts {
+    ConvOpts() :
+        fields(0), fields_level(0), depth(-1), offset(0), count(-1) {}
+
+    AV* fields;
+    int fields_level;  /* computed: 0 for a top-level object, 1 for an array */
+    int depth;
+    long offset;
+    long count;
+};
+
+/*
+ * Record an error to be raised in Perl once we are back out of V8.  Code that
+ * runs inside the isolate, and specially callbacks from JS into Perl, must not
+ * croak: the longjmp would skip the destructors of the V8 scopes and leave the
+ * isolate entered.  Instead, it records the error here and unwinds normally;
+ * V8Context croaks with it after leaving all the scopes.  Only the first error
+ * is kept.
+ *
+ * pl_fail_in_js also throws a JS exception, so that the JS code that called
+ * into Perl stops running; pl_type_fail_in_js throws a TypeError instead of a
+ * plain Error.
+ */
+void pl_fail(pTHX_ V8Context* ctx, const char* fmt, ...);
+void pl_fail_in_js(pTHX_ V8Context* ctx, const char* fmt, ...);
+void pl_type_fail_in_js(pTHX_ V8Context* ctx, const char* fmt, ...);
+
+/*
+ * Parse a hashref with conversion options (fields, depth, slice) into opts.
+ * Croaks on invalid options, so it must be called before entering V8.
+ */
+void pl_get_conv_opts(pTHX_ HV* opt, ConvOpts* opts);
+
 /*
  * We use these two functions to convert back and forth between the Perl
  * representation of an object and the JS one.
@@ -31,13 +77,13 @@ class V8Context;
  * pl_perl_to_v8: takes a Perl value and leaves the equivalent JS value at the
  * top of the V8 stack.
  */
-SV* pl_v8_to_perl(pTHX_ V8Context* ctx, const Local<Object>& object);
+SV* pl_v8_to_perl(pTHX_ V8Context* ctx, const Local<Object>& object, const ConvOpts* opts = 0);
 const Local<Object> pl_perl_to_v8(pTHX_ SV* value, V8Context* ctx);
 
 /*
  * Get the JS value of a global / nested property as Perl data.
  */
-SV* pl_get_global_or_property(pTHX_ V8Context* ctx, const char* name);
+SV* pl_get_global_or_property(pTHX_ V8Context* ctx, const char* name, const ConvOpts* opts = 0);
 
 /*
  * Return true if a given global / nested property exists.
@@ -59,6 +105,25 @@ SV* pl_instanceof_global_or_property(pTHX_ V8Context* ctx, const char* oname, co
  */
 int pl_set_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* value);
 
+/*
+ * Set a global / nested property whose value is computed on first access, by
+ * calling a Perl coderef and converting its result; V8 then caches the value
+ * in the property.  The getter may still be called again (for example through
+ * Reflect.get with another receiver), so the coderefs are kept until
+ * pl_lazy_tear_down releases them.
+ */
+int pl_set_lazy_global_or_property(pTHX_ V8Context* ctx, const char* name, SV* func);
+void pl_lazy_tear_down(pTHX_ V8Context* ctx);
+
+/*
+ * Get the JS values of several globals / nested properties, given as an array
+ * of names, into a hashref keyed by name.  Set several globals / nested
+ * properties from a hash of names to Perl data.  All values share the same
+ * conversion cache, so data shared among them is converted only once.
+ */
+SV* pl_get_globals_or_properties(pTHX_ V8Context* ctx, AV* names);
+int pl_set_globals_or_properties(pTHX_ V8Context* ctx, HV* values);
+
 /*
  * Delete a global / nested property.
  */
@@ -69,6 +134,25 @@ int pl_del_global_or_property(pTHX_ V8Context* ctx, const char* name);
  */
 int pl_run_gc(V8Context* ctx);
 
+/*
+ * Let V8 use the time until a deadline (based on the monotonic clock of the
+ * platform) to do garbage collection work, incrementally; return true if V8
+ * has nothing more to clean up for now.
+ */
+int pl_idle_gc(V8Context* ctx, double deadline_in_seconds);
+
+/*
+ * Tell V8 about the memory pressure in the system, so it can adjust how
+ * aggressively it collects garbage; a critical level triggers a full GC.
+ * pl_memory_pressure_level converts a level name into the level to pass, or
+ * returns -1 for an unknown name, so callers can croak before entering V8.
+ */
+#define PL_MEMORY_PRESSURE_NONE     "none"
+#define PL_MEMORY_PRESSURE_MODERATE "moderate"
+#define PL_MEMORY_PRESSURE_CRITICAL "critical"
+int pl_memory_pressure_level(const char* name);
+void pl_memory_pressure(V8Context* ctx, int level);
+
 SV* pl_global_objects(pTHX_ V8Context* ctx);
 
 bool find_parent(V8Context* ctx, const char* name, Local<Context>& context, Local<Object>& object, Local<Value>& slot, int create = 0);
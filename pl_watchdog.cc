@@ -0,0 +1,115 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "pl_sandbox.h"
+#include "pl_watchdog.h"
+#include "V8Context.h"
+
+typedef std::chrono::steady_clock Clock;
+typedef std::pair<Clock::time_point, V8Context*> Deadline;
+
+/*
+ * All the state for the watchdog thread.  This is allocated once and never
+ * released, so that it is still valid if the thread is running while the
+ * process exits.
+ */
+struct WatchdogState {
+    WatchdogState() : thread(0), running(false) {}
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<Deadline> deadlines;  /* sorted by time, earliest first */
+    std::thread* thread;
+    bool running;
+};
+
+static WatchdogState* watchdog = new WatchdogState;
+
+static void watchdog_loop(void)
+{
+    std::unique_lock<std::mutex> lock(watchdog->mutex);
+    while (watchdog->running) {
+        if (watchdog->deadlines.empty()) {
+            watchdog->cv.wait(lock);
+            continue;
+        }
+        std::set<Deadline>::iterator first = watchdog->deadlines.begin();
+        if (Clock::now() < first->first) {
+            watchdog->cv.wait_until(lock, first->first);
+            continue;
+        }
+
+        /* this context ran out of time; it will see that when disarming */
+        V8Context* ctx = first->second;
+        watchdog->deadlines.erase(first);
+        ctx->watchdog_armed = false;
+        ctx->terminate_reason = PL_TERMINATE_TIMEOUT;
+        ctx->isolate->TerminateExecution();
+    }
+}
+
+void pl_watchdog_arm(V8Context* ctx)
+{
+    if (ctx->watchdog_depth++ || !ctx->max_timeout_us) {
+        return;
+    }
+
+    Clock::time_point when = Clock::now() + std::chrono::microseconds((long) ctx->max_timeout_us);
+    std::lock_guard<std::mutex> lock(watchdog->mutex);
+    if (!watchdog->thread) {
+        watchdog->running = true;
+        watchdog->thread = new std::thread(watchdog_loop);
+    }
+    bool earliest = watchdog->deadlines.empty() || when < watchdog->deadlines.begin()->first;
+    watchdog->deadlines.insert(Deadline(when, ctx));
+    ctx->watchdog_deadline = when.time_since_epoch().count();
+    ctx->watchdog_armed = true;
+    if (earliest) {
+        watchdog->cv.notify_one();
+    }
+}
+
+static void forget_deadline(V8Context* ctx)
+{
+    std::lock_guard<std::mutex> lock(watchdog->mutex);
+    if (ctx->watchdog_armed) {
+        Clock::time_point when = Clock::time_point(Clock::duration(ctx->watchdog_deadline));
+        watchdog->deadlines.erase(Deadline(when, ctx));
+        ctx->watchdog_armed = false;
+    }
+}
+
+void pl_watchdog_disarm(V8Context* ctx)
+{
+    if (--ctx->watchdog_depth || !ctx->max_timeout_us) {
+        return;
+    }
+    forget_deadline(ctx);
+}
+
+void pl_watchdog_forget(V8Context* ctx)
+{
+    ctx->watchdog_depth = 0;
+    if (!ctx->max_timeout_us) {
+        return;
+    }
+    forget_deadline(ctx);
+}
+
+void pl_watchdog_stop(void)
+{
+    std::thread* thread = 0;
+    {
+        std::lock_guard<std::mutex> lock(watchdog->mutex);
+        thread = watchdog->thread;
+        watchdog->thread = 0;
+        watchdog->running = false;
+        watchdog->cv.notify_one();
+    }
+    if (thread) {
+        thread->join();
+        delete thread;
+    }
+}
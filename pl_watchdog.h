@@ -0,0 +1,36 @@
+#ifndef PL_WATCHDOG_H
+#define PL_WATCHDOG_H
+
+#include <v8.h>
+#include "pl_config.h"
+
+using namespace v8;
+class V8Context;
+
+/*
+ * Enforce a time limit on running JS code.
+ *
+ * There is a single watchdog thread for the whole process, which keeps the
+ * deadlines of all the contexts that are running JS code, sorted by time, and
+ * sleeps until the earliest one is due; when that happens, it asks V8 to
+ * terminate the execution in the isolate for that context.  The thread is
+ * started the first time a deadline is armed.
+ *
+ * pl_watchdog_arm / pl_watchdog_disarm are called around compiling / running
+ * JS code; they keep track of how deeply nested the calls are, only the
+ * outermost call for a context arms a deadline, and they do not take a lock
+ * for contexts without a time limit.
+ *
+ * pl_watchdog_forget drops the deadline for a context, if any, and resets the
+ * nesting; it is called when a context is torn down, and when a call from
+ * Perl starts, in case the previous one did not unwind normally.
+ *
+ * pl_watchdog_stop stops the watchdog thread, for example before forking;
+ * it will be started again when needed.
+ */
+void pl_watchdog_arm(V8Context* ctx);
+void pl_watchdog_disarm(V8Context* ctx);
+void pl_watchdog_forget(V8Context* ctx);
+void pl_watchdog_stop(void);
+
+#endif
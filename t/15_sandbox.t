@@ -26,43 +26,100 @@ JS
 }
 
 sub test_sandbox_memory {
-    # my $vm = $CLASS->new({ max_memory_bytes => 0});
-    my $vm = $CLASS->new();
+    my $vm = $CLASS->new({ max_memory_bytes => 0});
     ok($vm, "created $CLASS object with max_memory_bytes => 0");
 
-    SKIP: {
-        skip 'sandboxing not (yet) supported in V8', 1;
-        my $combined;
-        eval {
-            # $combined = combined_from(sub { $vm->eval(get_js()); });
-            $vm->eval(get_js());
-            1;
-        } or do {
-            $combined = $@ // 'zombie error';
-        };
-        like($combined,
-            qr/error: Error: (alloc failed|allocation failure)/,
-            "got correct error from memory sandbox");
+    my $combined;
+    eval {
+        $combined = combined_from(sub { $vm->eval(get_js()); });
+        1;
+    } or do {
+        $combined = $@ // 'zombie error';
     };
+    like($combined,
+        qr/error: Error: (alloc failed|allocation failure)/,
+        "got correct error from memory sandbox");
+
+    is($vm->eval('1 + 2'), 3, "can run code after hitting memory limit");
+}
+
+sub test_sandbox_array_buffer {
+    my $vm = $CLASS->new({ max_memory_bytes => 32 * 1024 * 1024 });
+    ok($vm, "created $CLASS object with max_memory_bytes => 32 MB");
+
+    is($vm->eval('new Uint8Array(1024 * 1024).length'), 1024 * 1024,
+       "can allocate array buffer under the limit");
+    like($vm->eval('try { new Uint8Array(64 * 1024 * 1024); "ok" } catch (e) { e.name }'),
+         qr/RangeError/, "cannot allocate array buffer over the limit");
 }
 
 sub test_sandbox_runtime {
     my $vm = $CLASS->new({ max_timeout_us => 0});
     ok($vm, "created $CLASS object with max_timeout_us => 0");
 
-    SKIP: {
-        skip 'sandboxing not (yet) supported in V8', 1;
-        stderr_like sub { $vm->eval(get_js()); },
-        qr/error: RangeError: execution timeout/,
-        "got correct error from runtime sandbox";
-    };
+    stderr_like sub { $vm->eval(get_js() . 'while (true) {}'); },
+    qr/error: RangeError: execution timeout/,
+    "got correct error from runtime sandbox";
+
+    is($vm->eval('1 + 2'), 3, "can run code after hitting time limit");
+
+    $vm->eval('function f() { while (true) {} }');
+    stderr_like sub { $vm->dispatch_function_in_event_loop('f'); },
+    qr/error: RangeError: execution timeout/,
+    "got correct error from runtime sandbox in dispatched function";
+}
+
+sub test_sandbox_no_timeout {
+    my $vm = $CLASS->new({ max_timeout_us => 2_000_000 });
+    ok($vm, "created $CLASS object with max_timeout_us => 2 s");
+
+    my $count = 0;
+    for (1..100) {
+        $count += $vm->eval('var s = 0; for (var j = 0; j < 1000; ++j) s += j; s') == 499500;
+    }
+    is($count, 100, "fast code is not affected by time limit");
+}
+
+sub test_sandbox_callback_dies {
+    my $vm = $CLASS->new({ max_timeout_us => 2_000_000 });
+    ok($vm, "created $CLASS object with max_timeout_us => 2 s");
+
+    $vm->set('boom', sub { die "gonzo\n" });
+    eval { $vm->eval('boom()'); };
+    like($@, qr/Perl sub died with error: gonzo/, "callback dying makes eval die");
+
+    eval { $vm->eval('try { boom(); "caught" } catch (e) { "ignored" }'); };
+    like($@, qr/Perl sub died with error: gonzo/, "callback dying cannot be caught in JS");
+
+    sleep 3;
+    is($vm->eval('1 + 2'), 3, "no stale deadline after callback died");
+
+    stderr_like sub { $vm->eval('while (true) {}'); },
+    qr/error: RangeError: execution timeout/,
+    "time limit still works after callback died";
+}
+
+sub test_sandbox_nested_timeout {
+    my $vm = $CLASS->new({ max_timeout_us => 0 });
+    ok($vm, "created $CLASS object with max_timeout_us => 0");
+
+    $vm->set('inner', sub { $vm->eval('while (true) {}'); return 1 });
+    stderr_like sub { $vm->eval('inner(); while (true) {}'); },
+    qr/error: RangeError: execution timeout/,
+    "timeout in nested eval also terminates the outer code";
+
+    is($vm->eval('1 + 2'), 3, "can run code after nested timeout");
 }
 
 sub main {
     use_ok($CLASS);
 
     test_sandbox_memory() for (1..2);
+    test_sandbox_array_buffer();
     test_sandbox_runtime();
+    test_sandbox_no_timeout();
+    test_sandbox_callback_dies();
+    test_sandbox_nested_timeout();
     done_testing;
     return 0;
 }
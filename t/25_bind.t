@@ -0,0 +1,105 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Hash::Util;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_bind_hash {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $config = {
+        name => 'gonzo',
+        nested => { list => [ 1, 2, 3 ], flag => 'yes' },
+        7 => 'seven',
+    };
+    $vm->bind('config', $config);
+
+    is($vm->eval('config.name'), 'gonzo', 'got scalar from bound hash');
+    is($vm->eval('config.nested.flag'), 'yes', 'got scalar from nested bound hash');
+    is($vm->eval('config[7]'), 'seven', 'got value for numeric key from bound hash');
+    is($vm->eval('config.missing'), undef, 'got undef for missing key in bound hash');
+    is($vm->eval('"name" in config'), 1, 'in operator works on bound hash');
+    is_deeply([ sort @{ $vm->eval('Object.keys(config)') } ],
+              [ sort keys %$config ], 'got all keys from bound hash');
+
+    $config->{name} = 'frodo';
+    is($vm->eval('config.name'), 'frodo', 'bound hash sees changes done in Perl');
+
+    $vm->eval('config.added = "from js"');
+    is($config->{added}, 'from js', 'Perl sees changes done in bound hash');
+
+    my $got = $vm->get('config');
+    is($got, $config, 'got the same Perl hash back from a bound hash');
+}
+
+sub test_bind_array {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $list = [ 10, 20, 30, { name => 'gonzo' } ];
+    $vm->bind('list', $list);
+
+    is($vm->eval('list.length'), 4, 'got length of bound array');
+    is($vm->eval('list[1]'), 20, 'got element from bound array');
+    is($vm->eval('list[3].name'), 'gonzo', 'got nested element from bound array');
+    is($vm->eval('list.slice(0, 3).reduce(function(a, b) { return a + b; }, 0)'), 60,
+       'Array methods work on bound array');
+
+    push @$list, 40;
+    is($vm->eval('list.length'), 5, 'bound array sees changes done in Perl');
+
+    my $got = $vm->get('list');
+    is($got, $list, 'got the same Perl array back from a bound array');
+}
+
+sub test_bind_errors {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    eval { $vm->bind('scalar', 42); 1 };
+    like($@, qr/Can only bind a hashref/, 'cannot bind a plain scalar');
+    eval { $vm->bind('code', sub { 1 }); 1 };
+    like($@, qr/Can only bind a hashref/, 'cannot bind a coderef');
+    is($vm->eval('typeof scalar'), 'undefined', 'failed binding was not set');
+}
+
+sub test_bind_locked {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $config = { name => 'gonzo' };
+    Hash::Util::lock_keys(%$config);
+    $vm->bind('config', $config);
+    is($vm->eval('config.missing'), undef, 'can read a missing key from a locked hash');
+    $vm->eval('config.name = "frodo"');
+    is($config->{name}, 'frodo', 'can change an allowed key in a locked hash');
+    eval { $vm->eval('config.other = 1') };
+    like($@, qr/Cannot store key other in locked bound hash/, 'cannot add a key to a locked hash');
+    ok(!exists $config->{other}, 'locked hash was not changed');
+
+    my $list = [ 1, 2, 3 ];
+    Internals::SvREADONLY(@$list, 1);
+    $vm->bind('list', $list);
+    eval { $vm->eval('try { list[0] = 9 } catch (e) { caught = e.name }') };
+    like($@, qr/Cannot store index 0 in read-only bound array/, 'cannot change a read-only array');
+    is($vm->eval('caught'), 'TypeError', 'changing a read-only array throws a TypeError in JS');
+    is_deeply($list, [ 1, 2, 3 ], 'read-only array was not changed');
+    is($vm->eval('1 + 2'), 3, 'context still works after failing to store');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_bind_hash();
+    test_bind_array();
+    test_bind_errors();
+    test_bind_locked();
+    done_testing;
+    return 0;
+}
+
+exit main();
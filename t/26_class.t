@@ -0,0 +1,59 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+package Counter {
+    sub new { my ($class, %args) = @_; return bless { count => $args{start} // 0 }, $class; }
+    sub incr { my ($self, $by) = @_; $self->{count} += $by // 1; return $self->{count}; }
+    sub count { my ($self) = @_; return $self->{count}; }
+    sub _private { return 'hidden'; }
+}
+
+sub test_registered_class {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->register_class('Counter');
+
+    my $counter = Counter->new(start => 10);
+    $vm->set('counter', $counter);
+
+    is($vm->typeof('counter'), 'object', 'registered object is an object in JS');
+    is($vm->eval('counter.count()'), 10, 'called method on registered object');
+    is($vm->eval('counter.incr(5)'), 15, 'called method with args on registered object');
+    is($counter->count(), 15, 'method call changed the Perl object');
+    is($vm->eval('typeof counter._private'), 'undefined', 'private methods are not exposed');
+
+    my $got = $vm->get('counter');
+    is($got, $counter, 'got the same Perl object back');
+    isa_ok($got, 'Counter');
+
+    $vm->set('counters', [ Counter->new(start => 1), Counter->new(start => 2) ]);
+    is($vm->eval('counters[0].count() + counters[1].count()'), 3, 'registered objects nested in data');
+    is($vm->eval('counters[0].count === counters[1].count'), 1, 'methods live in a shared prototype');
+}
+
+sub test_explicit_methods {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->register_class('Counter', [ 'count' ]);
+    $vm->set('counter', Counter->new(start => 7));
+    is($vm->eval('counter.count()'), 7, 'called listed method');
+    is($vm->eval('typeof counter.incr'), 'undefined', 'non-listed method is not exposed');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_registered_class();
+    test_explicit_methods();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,69 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_projection {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->eval(<<JS);
+var big = { id: 1, name: 'gonzo', nested: { a: { b: { c: 3 } } }, list: [ 0, 1, 2, 3, 4, 5 ] };
+var rows = [];
+for (var j = 0; j < 10; ++j) {
+    rows.push({ id: j, name: 'row ' + j, junk: [ j, j, j ] });
+}
+JS
+
+    my %cases = (
+        'fields in object' => [ 'big', { fields => [ qw/ id name missing / ] },
+                                { id => 1, name => 'gonzo' } ],
+        'inherited fields' => [ 'big', { fields => [ qw/ id toString constructor / ] },
+                                { id => 1 } ],
+        'depth 1' => [ 'big', { fields => [ qw/ id nested / ], depth => 1 },
+                       { id => 1, nested => undef } ],
+        'depth 3' => [ 'big.nested', { depth => 3 },
+                       { a => { b => { c => 3 } } } ],
+        'depth 2' => [ 'big.nested', { depth => 2 },
+                       { a => { b => undef } } ],
+        'slice' => [ 'big.list', { slice => [ 2, 3 ] },
+                     [ 2, 3, 4 ] ],
+        'slice negative offset' => [ 'big.list', { slice => [ -2 ] },
+                                     [ 4, 5 ] ],
+        'slice past the end' => [ 'big.list', { slice => [ 4, 10 ] },
+                                  [ 4, 5 ] ],
+        'fields in array slice' => [ 'rows', { fields => [ 'id' ], slice => [ 8 ] },
+                                     [ { id => 8 }, { id => 9 } ] ],
+    );
+    foreach my $label (sort keys %cases) {
+        my ($name, $opt, $expected) = @{ $cases{$label} };
+        my $got = $vm->get($name, $opt);
+        is_deeply($got, $expected, "got correct projected data for $label");
+    }
+}
+
+sub test_invalid_options {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->set('data', { foo => 1 });
+    eval { $vm->get('data', { bogus => 1 }); 1 };
+    like($@, qr/Unknown option bogus/, 'got error for unknown option');
+    eval { $vm->get('data', { fields => 'foo' }); 1 };
+    like($@, qr/must be an arrayref/, 'got error for invalid fields option');
+    is_deeply($vm->get('data'), { foo => 1 }, 'context still works after invalid options');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_projection();
+    test_invalid_options();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,59 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_eval_void {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my @got = $vm->eval_void('var big = []; for (var j = 0; j < 1000; ++j) { big.push({ j: j }); } big');
+    ok(!defined $got[0], 'eval_void does not return a value');
+    is($vm->eval('big.length'), 1000, 'code in eval_void did run');
+}
+
+sub test_max_convert_nodes {
+    my $vm = $CLASS->new({ max_convert_nodes => 100 });
+    ok($vm, "created $CLASS object with max_convert_nodes");
+
+    $vm->eval_void('var small = [ 1, 2, 3 ]; var big = []; for (var j = 0; j < 1000; ++j) { big.push(j); }');
+    is_deeply($vm->get('small'), [ 1, 2, 3 ], 'converted value under the limit');
+    eval { $vm->get('big'); 1 };
+    like($@, qr/exceeded maximum of 100 nodes/, 'got error for value over the node limit');
+    is_deeply($vm->get('big', { slice => [ 0, 3 ] }), [ 0, 1, 2 ], 'converted slice under the limit');
+
+    eval { $vm->get_many([ 'small', 'big' ]); 1 };
+    like($@, qr/exceeded maximum of 100 nodes/, 'got error for get_many over the node limit');
+    eval { $vm->eval('big'); 1 };
+    like($@, qr/exceeded maximum of 100 nodes/, 'got error for eval result over the node limit');
+    is($vm->eval('big.length'), 1000, 'context still works after hitting the limit');
+}
+
+sub test_max_convert_bytes {
+    my $vm = $CLASS->new({ max_convert_bytes => 1000 });
+    ok($vm, "created $CLASS object with max_convert_bytes");
+
+    $vm->eval_void('var short = "gonzo"; var long = "gonzo".repeat(1000);');
+    is($vm->get('short'), 'gonzo', 'converted string under the limit');
+    eval { $vm->get('long'); 1 };
+    like($@, qr/exceeded maximum of 1000 bytes/, 'got error for value over the byte limit');
+
+    $vm->eval_void('var wide = {}; for (var j = 0; j < 100; ++j) { wide["key_" + "x".repeat(50) + j] = 1; }');
+    eval { $vm->get('wide'); 1 };
+    like($@, qr/exceeded maximum of 1000 bytes/, 'got error for object keys over the byte limit');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_eval_void();
+    test_max_convert_nodes();
+    test_max_convert_bytes();
+    done_testing;
+    return 0;
+}
+
+exit main();
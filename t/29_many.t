@@ -0,0 +1,44 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_set_get_many {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $shared = { name => 'gonzo' };
+    my %values = (
+        number => 11,
+        string => 'bilbo',
+        list => [ 1, 2, 3 ],
+        first => $shared,
+        second => $shared,
+    );
+    $vm->set('slot', {});
+    $vm->set_many({ %values, 'slot.nested' => 'frodo' });
+
+    foreach my $name (sort keys %values) {
+        is_deeply($vm->get($name), $values{$name}, "got correct value for $name set with set_many");
+    }
+    is($vm->get('slot.nested'), 'frodo', 'set nested slot with set_many');
+    is($vm->eval('first === second'), 1, 'shared Perl data became a single JS object');
+
+    my $got = $vm->get_many([ sort(keys %values), 'slot.nested', 'missing' ]);
+    is_deeply($got, { %values, 'slot.nested' => 'frodo', missing => undef },
+              'got correct values with get_many');
+    is($got->{first}, $got->{second}, 'shared JS object became a single Perl hash');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_set_get_many();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,83 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_sync {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $state = {
+        user => { name => 'gonzo', roles => [ 'admin', 'dev' ] },
+        counter => 1,
+        stale => 'remove me',
+    };
+    $vm->sync('state', $state);
+    is_deeply($vm->get('state'), $state, 'got correct data after first sync');
+    $vm->eval_void('var user_before = state.user; var roles_before = state.user.roles;');
+
+    $state->{counter} = 2;
+    delete $state->{stale};
+    $state->{added} = [ 1, 2 ];
+    push @{ $state->{user}{roles} }, 'ops';
+    $vm->sync('state', $state);
+    is_deeply($vm->get('state'), $state, 'got correct data after second sync');
+    is($vm->eval('state.user === user_before'), 1, 'unchanged object kept its identity');
+    is($vm->eval('state.user.roles === roles_before'), 1, 'changed array kept its identity');
+
+    pop @{ $state->{user}{roles} };
+    pop @{ $state->{user}{roles} };
+    $state->{user} = { name => 'frodo' };
+    $vm->sync('state', $state);
+    is_deeply($vm->get('state'), $state, 'got correct data after third sync');
+    is($vm->eval('state.user === user_before'), 0, 'replaced object got a new identity');
+}
+
+sub test_sync_cycles {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $node = { name => 'root' };
+    $node->{self} = $node;
+    $vm->sync('node', $node);
+    is($vm->eval('node.self === node'), 1, 'cyclic data synced correctly');
+    $node->{name} = 'changed';
+    $vm->sync('node', $node);
+    is($vm->eval('node.self.name'), 'changed', 'cyclic data updated correctly');
+    delete $node->{self};
+}
+
+sub test_sync_errors {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $state = { a => 1, b => 2 };
+    $vm->sync('state', $state);
+    $vm->eval('Object.freeze(state)');
+    delete $state->{b};
+    eval { $vm->sync('state', $state) };
+    like($@, qr/Could not delete JS element while syncing/, 'cannot sync into a frozen object');
+
+    my $other = { x => 1 };
+    $vm->sync('other', $other);
+    $vm->eval('Object.defineProperty(other, "x", { get: function() { return 1 }, set: function() { throw new Error("no") } })');
+    $other->{x} = 2;
+    eval { $vm->sync('other', $other) };
+    like($@, qr/Could not set JS element while syncing/, 'setter that throws stops a sync');
+    is($vm->eval('1 + 2'), 3, 'context still works after failing to sync');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_sync();
+    test_sync_cycles();
+    test_sync_errors();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,95 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_bind_scalar {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $counter = 11;
+    $vm->bind_scalar('counter', \$counter);
+    is($vm->eval('counter'), 11, 'got initial value of bound scalar');
+
+    $counter = 42;
+    is($vm->eval('counter'), 42, 'bound scalar sees changes done in Perl');
+
+    $vm->eval('counter = counter + 1');
+    is($counter, 43, 'Perl sees changes done to bound scalar');
+
+    $counter = 'now a string';
+    is($vm->eval('typeof counter'), 'string', 'bound scalar follows Perl type');
+
+    my $other = 'other';
+    $vm->bind_scalar('counter', \$other);
+    is($vm->eval('counter'), 'other', 'rebinding a scalar uses the new one');
+}
+
+sub test_bind_nested_scalar {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $level = 'debug';
+    $vm->bind_scalar('app.config.level', \$level);
+    is($vm->eval('app.config.level'), 'debug', 'got value of nested bound scalar');
+
+    $vm->eval('app.config.level = "info"');
+    is($level, 'info', 'Perl sees changes done to nested bound scalar');
+}
+
+sub test_bind_scalar_reset {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $name = 'gonzo';
+    my $flag = 1;
+    $vm->bind_scalar('name', \$name);
+    $vm->bind_scalar('my.flag', \$flag);
+    $vm->reset();
+
+    $name = 'frodo';
+    is($vm->eval('name'), 'frodo', 'bound scalar survives reset');
+    is($vm->eval('my.flag'), 1, 'nested bound scalar survives reset');
+}
+
+sub test_bind_scalar_errors {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    eval { $vm->bind_scalar('bad', [ 1, 2 ]) };
+    like($@, qr/Can only bind a scalar reference/, 'cannot bind_scalar an arrayref');
+
+    eval { $vm->bind_scalar('bad', 'plain') };
+    like($@, qr/Can only bind a scalar reference/, 'cannot bind_scalar a plain scalar');
+    is($vm->eval('typeof bad'), 'undefined', 'failed binding was not set');
+
+    $vm->set('number', 42);
+    eval { $vm->bind_scalar('number.x', \my $x) };
+    like($@, qr/Could not bind scalar to number\.x/, 'cannot bind_scalar under a number');
+    $vm->reset();
+    is($vm->eval('1 + 2'), 3, 'reset works after failing to bind_scalar');
+
+    $vm->bind_scalar('fixed', \1);
+    is($vm->eval('fixed'), 1, 'can read a bound read-only scalar');
+    eval { $vm->eval('fixed = 2') };
+    like($@, qr/Cannot assign to read-only bound scalar fixed/, 'assigning to a read-only scalar dies');
+    eval { $vm->eval('try { fixed = 2 } catch (e) { caught = e.name }') };
+    is($vm->eval('caught'), 'TypeError', 'assigning to a read-only scalar throws a TypeError in JS');
+    is($vm->eval('fixed'), 1, 'read-only scalar was not changed');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_bind_scalar();
+    test_bind_nested_scalar();
+    test_bind_scalar_reset();
+    test_bind_scalar_errors();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,87 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_lazy {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my %calls;
+    $vm->set_lazy('big', sub { ++$calls{big}; return [ 1 .. 100 ] });
+    $vm->set_lazy('unused', sub { ++$calls{unused}; return { a => 1 } });
+    $vm->set_lazy('my.nested.name', sub { ++$calls{nested}; return 'gonzo' });
+    is_deeply(\%calls, {}, 'no lazy value computed before access');
+
+    is($vm->eval('big.length'), 100, 'got lazy value on first access');
+    is($vm->eval('big[99]'), 100, 'got lazy value on second access');
+    is($calls{big}, 1, 'lazy value computed only once');
+
+    is($vm->eval('my.nested.name'), 'gonzo', 'got nested lazy value');
+    is($calls{nested}, 1, 'nested lazy value computed once');
+
+    ok(!exists $calls{unused}, 'unused lazy value never computed');
+    is($vm->typeof('unused'), 'object', 'typeof computes lazy value');
+    is($calls{unused}, 1, 'lazy value computed by typeof');
+}
+
+sub test_lazy_reset {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $called = 0;
+    $vm->set_lazy('never', sub { ++$called; return 1 });
+    $vm->reset();
+    is($vm->typeof('never'), 'undefined', 'lazy value is gone after reset');
+    is($called, 0, 'lazy value never computed');
+}
+
+sub test_lazy_errors {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    eval { $vm->set_lazy('bad', 42) };
+    like($@, qr/Lazy value must be a code reference/, 'cannot set_lazy a non-coderef');
+
+    my $calls = 0;
+    $vm->set_lazy('flaky', sub { die "gonzo\n" if !$calls++; return 'ok' });
+    eval { $vm->eval('flaky') };
+    like($@, qr/Perl sub died with error: gonzo/, 'lazy value that dies makes eval die');
+    is($vm->eval('flaky'), 'ok', 'lazy value is computed again after dying');
+}
+
+sub test_lazy_receiver {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->set_lazy('name', sub { return 'gonzo' });
+    is($vm->eval('Reflect.get(this, "name", {})'), 'gonzo', 'got lazy value through another receiver');
+    is($vm->eval('Reflect.get(this, "name", {})'), 'gonzo', 'got lazy value through another receiver again');
+    is($vm->eval('name'), 'gonzo', 'got lazy value directly');
+}
+
+sub test_lazy_stats {
+    my $vm = $CLASS->new({ gather_stats => 1 });
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->set_lazy('slow', sub { return 42 });
+    is($vm->eval('slow'), 42, 'got lazy value');
+    is($vm->get_stats()->{callback}{calls}, 1, 'lazy computation is counted as a callback');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_lazy();
+    test_lazy_reset();
+    test_lazy_errors();
+    test_lazy_receiver();
+    test_lazy_stats();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,69 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_persistent {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $countries = { ar => 'Argentina', nl => 'Netherlands', list => [ 1, 2, 3 ] };
+    $vm->set_persistent('countries', $countries);
+    $vm->set_persistent('ref.data.pi', 3.14159);
+    $vm->set('transient', 1);
+    is_deeply($vm->get('countries'), $countries, 'got persistent value');
+
+    for my $round (1..3) {
+        $vm->eval('countries.ar = "changed"; transient = 2');
+        $vm->reset();
+        is_deeply($vm->get('countries'), $countries, "persistent value reinstalled after reset $round");
+        is($vm->get('ref.data.pi'), 3.14159, "nested persistent value reinstalled after reset $round");
+        is($vm->typeof('transient'), 'undefined', "normal value gone after reset $round");
+    }
+
+    $countries->{br} = 'Brazil';
+    $vm->reset();
+    ok(!exists $vm->get('countries')->{br}, 'persistent value was converted only once');
+
+    $vm->set_persistent('countries', { uy => 'Uruguay' });
+    $vm->reset();
+    is_deeply($vm->get('countries'), { uy => 'Uruguay' }, 'persistent value can be replaced');
+}
+
+sub test_persistent_errors {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    eval { $vm->set_persistent('func', { cb => sub { 1 } }) };
+    like($@, qr/Could not serialize persistent value/, 'cannot persist a function');
+    is($vm->eval('typeof func'), 'undefined', 'failed persistent value was not set');
+    is($vm->eval('1 + 2'), 3, 'context still works after failing to persist');
+
+    eval { $vm->set_persistent('bad.', 1) };
+    like($@, qr/Could not set persistent value for bad\./, 'cannot persist with an invalid name');
+    $vm->set_persistent('number', 42);
+    eval { $vm->set_persistent('number.x', 1) };
+    like($@, qr/Could not set persistent value for number\.x/, 'cannot persist under a number');
+    $vm->reset();
+    is($vm->get('number'), 42, 'reset works after failing to persist');
+    is($vm->eval('1 + 2'), 3, 'context still works after reset');
+
+    $vm->set_persistent('late.x', 1);
+    $vm->set_persistent('late', 7);
+    $vm->reset();
+    is($vm->get('late'), 7, 'persistent values that no longer fit are skipped on reset');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_persistent();
+    test_persistent_errors();
+    done_testing;
+    return 0;
+}
+
+exit main();
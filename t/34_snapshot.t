@@ -0,0 +1,84 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub get_js {
+    return <<JS;
+var lib = {
+    square: function(x) { return x * x; },
+    table: [ 1, 2, 3, 4, 5 ],
+};
+function greet(name) { return 'hello ' + name; }
+JS
+}
+
+sub test_snapshot {
+    my $dir = tempdir(CLEANUP => 1);
+    my $path = "$dir/lib.snapshot";
+
+    my $size = $CLASS->create_snapshot(get_js(), $path);
+    ok($size > 0, "created snapshot with $size bytes");
+    ok(-s $path, 'snapshot file exists');
+
+    my $vm = $CLASS->new({ snapshot => $path });
+    ok($vm, "created $CLASS object from snapshot");
+    is($vm->eval('lib.square(7)'), 49, 'called function from snapshot');
+    is($vm->eval('greet("gonzo")'), 'hello gonzo', 'called global function from snapshot');
+    is_deeply($vm->get('lib.table'), [ 1 .. 5 ], 'got data from snapshot');
+    is($vm->eval('typeof timestamp_ms()'), 'number', 'native functions work with snapshot');
+    is($vm->typeof('console'), 'object', 'console is available with snapshot');
+
+    $vm->eval('lib.square = null');
+    $vm->reset();
+    is($vm->eval('lib.square(3)'), 9, 'reset boots again from snapshot');
+
+    my $plain = $CLASS->new();
+    is($plain->typeof('lib'), 'undefined', 'instances without snapshot are not affected');
+}
+
+sub test_snapshot_replace {
+    my $dir = tempdir(CLEANUP => 1);
+    my $path = "$dir/lib.snapshot";
+
+    $CLASS->create_snapshot(get_js(), $path);
+    my $old = $CLASS->new({ snapshot => $path });
+    ok($old, "created $CLASS object from snapshot");
+
+    $CLASS->create_snapshot('var version = 2;', $path);
+    ok(!-e "$path.tmp", 'no temporary file left behind');
+    $old->reset();
+    is($old->eval('lib.square(5)'), 25, 'replacing a snapshot does not affect instances using it');
+
+    my $new = $CLASS->new({ snapshot => $path });
+    is($new->eval('version'), 2, 'new instances use the new snapshot');
+}
+
+sub test_snapshot_errors {
+    my $dir = tempdir(CLEANUP => 1);
+    my $path = "$dir/bad.snapshot";
+
+    eval { $CLASS->create_snapshot('this is not valid JS', $path) };
+    like($@, qr/Could not create snapshot/, 'cannot create snapshot from invalid code');
+    ok(!-e $path, 'no snapshot file left behind');
+    ok(!-e "$path.tmp", 'no temporary file left behind');
+
+    eval { $CLASS->new({ snapshot => "$dir/missing.snapshot" }) };
+    like($@, qr/Could not open snapshot file/, 'cannot use missing snapshot file');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_snapshot();
+    test_snapshot_replace();
+    test_snapshot_errors();
+    done_testing;
+    return 0;
+}
+
+exit main();
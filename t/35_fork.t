@@ -0,0 +1,113 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use File::Temp qw(tempdir);
+use Time::HiRes qw(sleep);
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_configure {
+    $CLASS->configure({ prefork => 1 });
+    ok(1, 'configured prefork mode');
+
+    eval { $CLASS->configure({ no_such_option => 1 }) };
+    like($@, qr/Unknown option/, 'cannot configure unknown option');
+}
+
+sub test_fork {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object in parent");
+    $vm->eval('function fib(n) { return n < 2 ? n : fib(n-1) + fib(n-2); }');
+    is($vm->eval('fib(20)'), 6765, 'ran code in parent');
+
+    eval { $CLASS->configure({ prefork => 1 }) };
+    like($@, qr/already initialized/, 'cannot configure after creating an instance');
+
+    my $children = 3;
+    my @pids;
+    $CLASS->prepare_fork();
+    for my $child (1..$children) {
+        my $pid = fork();
+        die "cannot fork: $!" unless defined $pid;
+        if ($pid == 0) {
+            $CLASS->after_fork_child();
+            my $ok = $vm->eval("fib(15) + $child") == 610 + $child;
+            my $other = $CLASS->new();
+            $ok &&= $other->eval('1 + 2') == 3;
+            $vm->run_gc();
+            exit($ok ? 0 : 1);
+        }
+        push @pids, $pid;
+    }
+    for my $pid (@pids) {
+        waitpid($pid, 0);
+        is($?, 0, "child $pid used V8 after fork");
+    }
+    is($vm->eval('fib(10)'), 55, 'parent still works after forking');
+
+    eval { $CLASS->after_fork_child() };
+    like($@, qr/must be called in the child/, 'cannot call after_fork_child in parent');
+}
+
+sub write_file {
+    my ($path, $value) = @_;
+    open my $fh, '>', "$path.tmp" or die "Cannot write $path.tmp: $!";
+    print $fh "$value\n";
+    close $fh;
+    rename "$path.tmp", $path or die "Cannot rename to $path: $!";
+}
+
+sub wait_for {
+    my ($check) = @_;
+    foreach (1..200) {
+        return 1 if $check->();
+        sleep(0.01);
+    }
+    return 0;
+}
+
+sub test_fork_monitor {
+    my $dir = tempdir(CLEANUP => 1);
+    my $current = "$dir/memory.current";
+    my $max = "$dir/memory.max";
+    write_file($current, 100);
+    write_file($max, 1000);
+
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object in parent");
+    ok($CLASS->start_memory_monitor({
+        interval_ms  => 10,
+        current_file => $current,
+        max_file     => $max,
+    }), "started memory monitor");
+    my $critical = sub { return $vm->get_stats()->{memory_monitor}{critical} || 0 };
+
+    $CLASS->prepare_fork();
+    my $pid = fork();
+    die "cannot fork: $!" unless defined $pid;
+    if ($pid == 0) {
+        $CLASS->after_fork_child();
+        write_file($current, 990);
+        exit(wait_for(sub { $critical->() > 0 }) ? 0 : 1);
+    }
+    waitpid($pid, 0);
+    is($?, 0, "after_fork_child starts the memory monitor again in the child");
+
+    $vm->eval('1 + 1');
+    ok(wait_for(sub { $critical->() > 0 }), "memory monitor runs again in the parent");
+    $CLASS->stop_memory_monitor();
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_configure();
+    test_fork();
+    test_fork_monitor();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,32 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_platform {
+    $CLASS->configure({ thread_pool_size => 2, idle_tasks => 0 });
+    ok(1, 'configured platform options');
+
+    my @vms = map { $CLASS->new() } 1..3;
+    for my $vm (@vms) {
+        $vm->eval('var list = []; for (var j = 0; j < 100000; ++j) list.push({ j: j });');
+        is($vm->eval('list.length'), 100000, 'ran code with a small thread pool');
+        $vm->run_gc();
+    }
+
+    eval { $CLASS->configure({ thread_pool_size => 8 }) };
+    like($@, qr/already initialized/, 'cannot change thread pool size after creating an instance');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_platform();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,41 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_profile {
+    eval { $CLASS->configure({ profile => 'no_such_profile' }) };
+    like($@, qr/Unknown profile/, 'cannot use unknown profile');
+
+    $CLASS->configure({ profile => 'low_memory' });
+    ok(1, 'configured low_memory profile');
+
+    $CLASS->set_flags('--expose-gc');
+    ok(1, 'set flags');
+}
+
+sub test_flags {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    is($vm->eval('typeof gc'), 'function', 'flag to expose gc took effect');
+    $vm->eval('var list = []; for (var j = 0; j < 100000; ++j) list.push("str" + j); gc();');
+    is($vm->eval('list.length'), 100000, 'ran code with low_memory profile');
+
+    eval { $CLASS->set_flags('--jitless') };
+    like($@, qr/already initialized/, 'cannot set flags after creating an instance');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_profile();
+    test_flags();
+    done_testing;
+    return 0;
+}
+
+exit main();
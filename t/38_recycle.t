@@ -0,0 +1,92 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_recycle_after_evals {
+    my $vm = $CLASS->new({ recycle_after_evals => 3 });
+    ok($vm, "created $CLASS object with recycle_after_evals");
+
+    my $countries = { ar => 'Argentina', nl => 'Netherlands' };
+    $vm->set_persistent('countries', $countries);
+    my $level = 'debug';
+    $vm->bind_scalar('level', \$level);
+
+    $vm->eval('var counter = 0');
+    $vm->eval('counter++');
+    is($vm->eval('counter'), 1, 'state is kept before recycling');
+    is($vm->typeof('counter'), 'undefined', 'state is gone after recycling');
+    is_deeply($vm->get('countries'), $countries, 'persistent values survive recycling');
+    is($vm->eval('level'), 'debug', 'bound scalars survive recycling');
+
+    my $stats = $vm->get_stats();
+    is($stats->{recycle}{count}, 1, 'recycling is counted in stats');
+    is($stats->{recycle}{evals}, 1, 'recycling reason is counted in stats');
+    ok($stats->{recycle}{elapsed_us} >= 0, 'recycling time is recorded in stats');
+
+    for (1..9) {
+        $vm->eval('1');
+    }
+    is($vm->eval('1 + 2'), 3, 'can run code after recycling many times');
+    is($vm->get_stats()->{recycle}{count}, 4, 'recycled the expected number of times');
+}
+
+sub test_recycle_above_heap_bytes {
+    my $vm = $CLASS->new({ recycle_above_heap_bytes => 32 * 1024 * 1024 });
+    ok($vm, "created $CLASS object with recycle_above_heap_bytes");
+
+    $vm->eval('var leak = []; for (var j = 0; j < 1000000; ++j) leak.push({ j: j, s: "str" + j });');
+    $vm->eval('1');
+    is($vm->typeof('leak'), 'undefined', 'recycled after heap grew');
+    is($vm->get_stats()->{recycle}{heap_bytes}, 1, 'recycled because of heap size');
+}
+
+sub test_recycle_after_seconds {
+    my $vm = $CLASS->new({ recycle_after_seconds => 0.2 });
+    ok($vm, "created $CLASS object with recycle_after_seconds");
+
+    $vm->eval('var old = 1');
+    select(undef, undef, undef, 0.3);
+    $vm->eval('1');
+    is($vm->typeof('old'), 'undefined', 'recycled after some time');
+    is($vm->get_stats()->{recycle}{seconds}, 1, 'recycled because of time');
+}
+
+sub test_recycle_stack_overflow {
+    my $vm = $CLASS->new({ recycle_after_evals => 1 });
+    ok($vm, "created $CLASS object with recycle_after_evals => 1");
+
+    $vm->eval('1') for 1..3;
+    ok($vm->get_stats()->{recycle}{count} >= 2, 'recycled a few times');
+    is($vm->eval('function deep(n) { return deep(n + 1) + 1; } ' .
+                 'try { deep(0); "ok" } catch (e) { e.name }'),
+       'RangeError', 'stack overflow is detected after recycling');
+    is($vm->eval('1 + 2'), 3, 'can run code after a stack overflow');
+}
+
+sub test_no_recycle {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object without recycling");
+
+    $vm->eval('var counter = 0');
+    $vm->eval('counter++') for 1..10;
+    is($vm->eval('counter'), 10, 'state is kept without recycling');
+    ok(!exists $vm->get_stats()->{recycle}, 'no recycling stats');
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_recycle_after_evals();
+    test_recycle_above_heap_bytes();
+    test_recycle_after_seconds();
+    test_recycle_stack_overflow();
+    test_no_recycle();
+    done_testing;
+    return 0;
+}
+
+exit main();
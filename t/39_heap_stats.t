@@ -0,0 +1,57 @@
+use strict;
+use warnings;
+
+use Data::Dumper;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_heap_stats {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $before = $vm->get_heap_stats();
+    foreach my $name (qw/ total_heap_size used_heap_size heap_size_limit malloced_memory number_of_native_contexts /) {
+        ok(exists $before->{heap}{$name}, "got heap stat $name");
+    }
+    ok($before->{heap}{used_heap_size} > 0, 'used heap size is positive');
+    ok(exists $before->{spaces}{old_space}, 'got stats for old space');
+    ok(exists $before->{spaces}{new_space}, 'got stats for new space');
+    foreach my $name (qw/ space_size space_used_size space_available_size physical_space_size /) {
+        ok(exists $before->{spaces}{old_space}{$name}, "got space stat $name");
+    }
+    ok(exists $before->{code}{bytecode_and_metadata_size}, 'got code stats');
+    ok(exists $before->{external_memory}, 'got external memory');
+
+    $vm->eval('var keep = []; for (var j = 0; j < 100000; ++j) keep.push({ j: j });');
+    my $after = $vm->get_heap_stats();
+    ok($after->{heap}{used_heap_size} > $before->{heap}{used_heap_size}, 'used heap grows when keeping objects');
+
+    $vm->eval('var buffer = new ArrayBuffer(4 * 1024 * 1024);');
+    my $external = $vm->get_heap_stats();
+    ok($external->{external_memory} >= 4 * 1024 * 1024, 'array buffers count as external memory');
+}
+
+sub test_allocated_bytes {
+    my $vm = $CLASS->new({ gather_stats => 1 });
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->eval('var keep = []; for (var j = 0; j < 100000; ++j) keep.push({ j: j });');
+    my $big = $vm->get_stats()->{run}{memory_bytes};
+    ok($big > 100000 * 8, "got allocated bytes for a big run: $big");
+
+    $vm->eval('var tmp = []; for (var j = 0; j < 1000000; ++j) { tmp.push({ j: j }); if (tmp.length > 1000) tmp = []; }');
+    my $garbage = $vm->get_stats()->{run}{memory_bytes};
+    ok($garbage > 1000000 * 8, "allocated bytes include garbage collected memory: $garbage");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_heap_stats();
+    test_allocated_bytes();
+    done_testing;
+    return 0;
+}
+
+exit main();
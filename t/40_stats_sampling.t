@@ -0,0 +1,74 @@
+use strict;
+use warnings;
+
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_counts {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->set('x', 1) for 1..5;
+    $vm->get('x') for 1..3;
+    my $stats = $vm->get_stats();
+    is($stats->{set}{calls}, 5, "counted all calls to set");
+    is($stats->{set}{samples}, 5, "measured all calls to set");
+    is($stats->{get}{calls}, 3, "counted all calls to get");
+    foreach my $name (qw/ elapsed_us cpu_us memory_bytes /) {
+        ok(exists $stats->{get}{$name}, "name $name exists in stats for get");
+        ok($stats->{get}{$name} >= 0, "name $name has a valid value in stats for get");
+    }
+    ok(!exists $stats->{remove}, "category remove does not exist in stats");
+
+    $vm->reset_stats();
+    $stats = $vm->get_stats();
+    ok(!exists $stats->{set}, "category set is gone after reset_stats");
+    $vm->set('x', 2);
+    $stats = $vm->get_stats();
+    is($stats->{set}{calls}, 1, "counting starts again after reset_stats");
+}
+
+sub test_sampling {
+    my $vm = $CLASS->new({gather_stats => 1, stats_sample_rate => 4});
+    ok($vm, "created $CLASS object with stats_sample_rate");
+
+    $vm->set('x', $_) for 1..10;
+    my $stats = $vm->get_stats();
+    is($stats->{set}{calls}, 10, "counted all calls to set when sampling");
+    is($stats->{set}{samples}, 3, "measured 1 in 4 calls to set");
+}
+
+sub test_sampling_interleaved {
+    my $vm = $CLASS->new({gather_stats => 1, stats_sample_rate => 2});
+    ok($vm, "created $CLASS object with stats_sample_rate");
+
+    # each eval does a compile and then a run
+    $vm->eval('1 + 1') for 1..6;
+    $vm->set('x', 1);
+    my $stats = $vm->get_stats();
+    foreach my $name (qw/ compile run /) {
+        is($stats->{$name}{calls}, 6, "counted all calls to $name");
+        is($stats->{$name}{samples}, 3, "measured 1 in 2 calls to $name");
+    }
+    is($stats->{set}{calls}, 1, "counted the call to set");
+    is($stats->{set}{samples}, 1, "measured the first call to set");
+
+    $vm->reset_stats();
+    $vm->set('x', 1);
+    $vm->set('x', 2);
+    $stats = $vm->get_stats();
+    is($stats->{set}{samples}, 1, "measured 1 in 2 calls to set after reset_stats");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_counts();
+    test_sampling();
+    test_sampling_interleaved();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,54 @@
+use strict;
+use warnings;
+
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_histograms {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->eval('var n = 0; function inc(x) { n += x; return n; }');
+    $vm->eval('inc(1)') for 1..50;
+    my $stats = $vm->get_stats();
+    my $run = $stats->{run};
+    ok($run, "category run exists in stats");
+    is($run->{elapsed_us_count}, $run->{samples}, "histogram counts all samples");
+    ok($run->{elapsed_us_min} <= $run->{elapsed_us_p50}, "min <= p50");
+    ok($run->{elapsed_us_p50} <= $run->{elapsed_us_p90}, "p50 <= p90");
+    ok($run->{elapsed_us_p90} <= $run->{elapsed_us_p99}, "p90 <= p99");
+    ok($run->{elapsed_us_p99} <= $run->{elapsed_us_p999}, "p99 <= p999");
+    ok($run->{elapsed_us_p999} <= $run->{elapsed_us_max}, "p999 <= max");
+    ok($run->{elapsed_us_sum} >= $run->{elapsed_us_max}, "sum >= max");
+}
+
+sub test_timers {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->set('perl_add', sub { return $_[0] + $_[1] });
+    is($vm->eval('perl_add(2, 3)'), 5, "called Perl callback");
+    $vm->set('data', { list => [1..100] });
+    $vm->run_gc();
+
+    my $stats = $vm->get_stats();
+    foreach my $category (qw/ convert callback gc /) {
+        my $data = $stats->{$category};
+        ok($data, "category $category exists in stats");
+        ok($data->{elapsed_us_count} > 0, "category $category has samples");
+        ok(!exists $data->{memory_bytes}, "category $category has no memory_bytes");
+    }
+    is($stats->{callback}{calls}, 1, "counted one Perl callback");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_histograms();
+    test_timers();
+    done_testing;
+    return 0;
+}
+
+exit main();
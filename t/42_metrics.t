@@ -0,0 +1,47 @@
+use strict;
+use warnings;
+
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_metrics {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object with gather_stats");
+
+    $vm->set('x', 1) for 1..3;
+    $vm->eval('x + 1');
+
+    my $text = $CLASS->metrics_text();
+    ok($text, "got metrics text");
+    like($text, qr/\n# EOF\n\z/, "metrics text ends with EOF marker");
+    like($text, qr/^# TYPE v8xs_operation_seconds histogram$/m, "operation histogram is declared");
+    like($text, qr/^v8xs_operation_calls_total\{op="set"\} 3$/m, "calls to set are counted");
+    like($text, qr/^v8xs_operation_seconds_bucket\{op="run",le="\+Inf"\} \d+$/m, "run histogram has +Inf bucket");
+    like($text, qr/^v8xs_operation_seconds_count\{op="run"\} \d+$/m, "run histogram has count");
+    like($text, qr/^v8xs_operation_seconds_sum\{op="run"\} [\d.e+-]+$/m, "run histogram has sum");
+    like($text, qr/^v8xs_contexts 1$/m, "one live context");
+    like($text, qr/^v8xs_heap_used_bytes \d+/m, "heap used bytes are reported");
+    like($text, qr/^v8xs_heap_space_used_bytes\{space="\w+"\} \d+/m, "heap spaces are reported");
+    like($text, qr/^v8xs_timers_pending 0$/m, "no timers pending");
+
+    my $other = $CLASS->new();
+    $text = $CLASS->metrics_text();
+    like($text, qr/^v8xs_contexts 2$/m, "two live contexts");
+    $other->set('x', 1);
+    $text = $CLASS->metrics_text();
+    like($text, qr/^v8xs_operation_calls_total\{op="set"\} 3$/m, "calls without gather_stats are not counted");
+    undef $other;
+    $text = $CLASS->metrics_text();
+    like($text, qr/^v8xs_contexts 1$/m, "back to one live context");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_metrics();
+    done_testing;
+    return 0;
+}
+
+exit main();
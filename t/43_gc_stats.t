@@ -0,0 +1,59 @@
+use strict;
+use warnings;
+
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub test_gc_stats {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object with gather_stats");
+
+    # escaping objects, so they really get allocated in the heap
+    $vm->eval('var keep = []; for (var j = 0; j < 200000; ++j) { keep.push({j: j}); if (keep.length > 1000) keep = []; }');
+    $vm->run_gc();
+
+    my $stats = $vm->get_stats();
+    my $gc = $stats->{gc};
+    ok($gc, "category gc exists in stats");
+    ok($gc->{calls} > 0, "some GCs were recorded");
+
+    my $by_type = 0;
+    foreach my $type (qw/ gc_scavenge gc_mark_compact gc_incremental gc_weak_callbacks /) {
+        next unless exists $stats->{$type};
+        ok($stats->{$type}{elapsed_us_sum} >= 0, "GC time for $type is valid");
+        $by_type += $stats->{$type}{calls};
+    }
+    is($by_type, $gc->{calls}, "GCs by type add up to all GCs");
+
+    my $run_gc = $stats->{run_gc};
+    ok($run_gc->{gc_count} > 0, "GCs were charged to run_gc");
+    ok($run_gc->{gc_us} >= 0, "GC time charged to run_gc is valid");
+    ok($stats->{run}{gc_count} > 0, "GCs were charged to run");
+
+    my $attributed = 0;
+    foreach my $op (keys %$stats) {
+        next unless exists $stats->{$op}{gc_count};
+        $attributed += $stats->{$op}{gc_count};
+    }
+    ok($attributed <= $gc->{calls}, "no GC was charged twice");
+}
+
+sub test_no_gc_stats {
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object without gather_stats");
+    $vm->run_gc();
+    my $stats = $vm->get_stats();
+    ok(!exists $stats->{gc}, "category gc does not exist in stats");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_gc_stats();
+    test_no_gc_stats();
+    done_testing;
+    return 0;
+}
+
+exit main();
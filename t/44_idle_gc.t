@@ -0,0 +1,65 @@
+use strict;
+use warnings;
+
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub make_garbage {
+    my ($vm) = @_;
+    # escaping objects, so they really get allocated in the heap
+    $vm->eval('var keep = []; for (var j = 0; j < 100000; ++j) { keep.push({j: j}); } keep = null;');
+}
+
+sub test_idle_gc {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object");
+
+    make_garbage($vm);
+    my $before = $vm->get_heap_stats()->{heap}{used_heap_size};
+    my $done = 0;
+    foreach my $round (1..100) {
+        $done = $vm->idle_gc(10);
+        last if $done;
+    }
+    ok($done, "idle GC finished its work");
+    my $after = $vm->get_heap_stats()->{heap}{used_heap_size};
+    ok($after < $before, "idle GC freed the garbage");
+    is($vm->eval('1 + 1'), 2, "context still works after idle GC");
+
+    my $stats = $vm->get_stats();
+    ok($stats->{idle_gc}{calls} > 0, "idle GC calls are in stats");
+
+    ok(defined $vm->idle_gc(0), "idle GC with a zero deadline");
+    ok(defined $vm->idle_gc(-5), "idle GC with a negative deadline");
+}
+
+sub test_memory_pressure {
+    my $vm = $CLASS->new({gather_stats => 1});
+    ok($vm, "created $CLASS object");
+
+    make_garbage($vm);
+    foreach my $level (qw/ moderate critical none /) {
+        eval { $vm->memory_pressure($level); };
+        is($@, '', "set memory pressure to $level");
+    }
+    my $stats = $vm->get_stats();
+    ok($stats->{memory_pressure}{gc_count} > 0, "critical memory pressure ran a GC");
+    ok($stats->{gc_mark_compact}{calls} > 0, "the GC was a full one");
+    is($vm->eval('1 + 1'), 2, "context still works after memory pressure");
+
+    eval { $vm->memory_pressure('extreme'); };
+    like($@, qr/Unknown memory pressure level extreme/, "invalid memory pressure level dies");
+    is($vm->eval('1 + 1'), 2, "context still works after invalid memory pressure level");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_idle_gc();
+    test_memory_pressure();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,144 @@
+use strict;
+use warnings;
+
+use File::Temp qw(tempdir);
+use Time::HiRes qw(sleep);
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub write_file {
+    my ($path, $value) = @_;
+    open my $fh, '>', "$path.tmp" or die "Cannot write $path.tmp: $!";
+    print $fh "$value\n";
+    close $fh;
+    rename "$path.tmp", $path or die "Cannot rename to $path: $!";
+}
+
+sub wait_for {
+    my ($check) = @_;
+    foreach (1..200) {
+        return 1 if $check->();
+        sleep(0.01);
+    }
+    return 0;
+}
+
+sub test_monitor {
+    my $dir = tempdir(CLEANUP => 1);
+    my $current = "$dir/memory.current";
+    my $max = "$dir/memory.max";
+    write_file($current, 100);
+    write_file($max, 1000);
+
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    my $started = $CLASS->start_memory_monitor({
+        interval_ms  => 10,
+        moderate     => 0.5,
+        critical     => 0.9,
+        current_file => $current,
+        max_file     => $max,
+    });
+    ok($started, "started memory monitor with explicit files");
+
+    my $events = sub { return $vm->get_stats()->{memory_monitor}{$_[0]} || 0 };
+
+    write_file($current, 600);
+    ok(wait_for(sub { $events->('moderate') == 1 }), "moderate pressure was sent");
+    write_file($current, 950);
+    ok(wait_for(sub { $events->('critical') == 1 }), "critical pressure was sent");
+    write_file($current, 100);
+    ok(wait_for(sub { $events->('none') == 1 }), "pressure went back to none");
+    sleep(0.1);
+    is($events->('moderate'), 1, "no repeated events while the level does not change");
+
+    is($vm->eval('1 + 1'), 2, "context still works after memory pressure");
+
+    my $text = $CLASS->metrics_text();
+    like($text, qr/^v8xs_cgroup_memory_max_bytes 1000$/m, "cgroup limit is in metrics");
+    like($text, qr/^v8xs_memory_pressure_events_total\{level="critical"\} 1$/m, "pressure events are in metrics");
+
+    $CLASS->stop_memory_monitor();
+    write_file($current, 950);
+    sleep(0.1);
+    is($events->('critical'), 1, "no events after stopping the monitor");
+}
+
+sub test_options {
+    eval { $CLASS->start_memory_monitor({moderate => 0.9, critical => 0.5}) };
+    like($@, qr/thresholds/, "invalid thresholds die");
+    eval { $CLASS->start_memory_monitor({current_file => '/dev/null'}) };
+    like($@, qr/must be given together/, "only one file dies");
+    eval { $CLASS->start_memory_monitor({gonzo => 1}) };
+    like($@, qr/Unknown option gonzo/, "unknown option dies");
+
+    my $started = $CLASS->start_memory_monitor();
+    ok(defined $started, "started memory monitor with cgroup discovery: " . ($started ? "found" : "not found"));
+    eval {
+        $CLASS->stop_memory_monitor();
+        $CLASS->stop_memory_monitor();
+    };
+    is($@, '', "stopping the monitor twice is fine");
+}
+
+sub test_unlimited {
+    my $dir = tempdir(CLEANUP => 1);
+    my $current = "$dir/memory.current";
+    my $max = "$dir/memory.max";
+    write_file($current, 1_000_000);
+    write_file($max, 'max');
+
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+    ok($CLASS->start_memory_monitor({
+        interval_ms  => 10,
+        current_file => $current,
+        max_file     => $max,
+    }), "started memory monitor for a cgroup without a limit");
+    ok(wait_for(sub { $CLASS->metrics_text() =~ /^v8xs_cgroup_memory_current_bytes 1000000$/m }),
+       "memory monitor read the usage");
+    is_deeply($vm->get_stats()->{memory_monitor} || {}, {}, "no pressure without a limit");
+    $CLASS->stop_memory_monitor();
+}
+
+sub test_idle_context {
+    my $dir = tempdir(CLEANUP => 1);
+    my $current = "$dir/memory.current";
+    my $max = "$dir/memory.max";
+    write_file($current, 100);
+    write_file($max, 1000);
+
+    my $vm = $CLASS->new({ gather_stats => 1 });
+    ok($vm, "created $CLASS object with gather_stats");
+    $vm->eval('var junk = []; for (var j = 0; j < 100000; ++j) { junk.push({ j: j }); } junk = null;');
+    my $full_gcs = sub { return $vm->get_stats()->{gc_mark_compact}{calls} || 0 };
+    my $before = $full_gcs->();
+
+    $CLASS->start_memory_monitor({
+        interval_ms  => 10,
+        current_file => $current,
+        max_file     => $max,
+    });
+    write_file($current, 990);
+    ok(wait_for(sub { ($vm->get_stats()->{memory_monitor}{critical} || 0) == 1 }), "critical pressure was sent");
+
+    # no JS runs here: the GC comes from the tasks V8 posted for the isolate
+    $vm->set('x', 1);
+    ok($full_gcs->() > $before, "idle context ran a full GC on its next call");
+    $CLASS->stop_memory_monitor();
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_monitor();
+    test_options();
+    test_unlimited();
+    test_idle_context();
+    done_testing;
+    return 0;
+}
+
+exit main();
@@ -0,0 +1,110 @@
+use strict;
+use warnings;
+
+use File::Temp qw(tempdir);
+use JSON::PP;
+use Test::More;
+
+my $CLASS = 'JavaScript::V8::XS';
+
+sub slurp {
+    my ($path) = @_;
+    open my $fh, '<', $path or die "Cannot read $path: $!";
+    local $/;
+    my $data = <$fh>;
+    close $fh;
+    return $data;
+}
+
+sub test_profiling {
+    my $dir = tempdir(CLEANUP => 1);
+    my $path = "$dir/fib.cpuprofile";
+    my $folded = "$dir/fib.folded";
+
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    $vm->eval('function fib(n) { return n <= 1 ? 1 : fib(n-1) + fib(n-2); }', 'fib.js');
+    $vm->start_profiling('fib', {
+        sampling_interval_us => 100,
+        path                 => $path,
+        folded               => $folded,
+    });
+    $vm->eval('fib(25)') for 1..5;
+    my $got = $vm->stop_profiling('fib');
+    is($got, $path, "stop_profiling returns the path of the profile");
+
+    ok(-s $path, "profile was written");
+    my $profile = decode_json(slurp($path));
+    ok(ref $profile->{nodes} eq 'ARRAY' && @{ $profile->{nodes} }, "profile has nodes");
+    is($profile->{nodes}[0]{callFrame}{functionName}, '(root)', "first node is the root");
+    is(scalar @{ $profile->{samples} }, scalar @{ $profile->{timeDeltas} }, "one time delta per sample");
+    ok($profile->{endTime} >= $profile->{startTime}, "profile has valid start and end times");
+
+    my %ids = map { $_->{id} => $_ } @{ $profile->{nodes} };
+    my @missing = grep { !exists $ids{$_} } @{ $profile->{samples} };
+    ok(!@missing, "all samples refer to existing nodes");
+    my @fib = grep { $_->{callFrame}{functionName} eq 'fib' } @{ $profile->{nodes} };
+    ok(@fib, "function fib appears in the profile");
+    like($fib[0]{callFrame}{url}, qr/fib\.js$/, "function fib has its script name") if @fib;
+
+    ok(-s $folded, "folded stacks were written");
+    my @lines = split /\n/, slurp($folded);
+    my @bad = grep { !/^[^;]+(;[^;]+)* \d+$/ } @lines;
+    ok(!@bad, "folded stacks have the right format");
+    ok((grep { /(^|;)fib \(fib\.js:\d+\)/ } @lines), "function fib appears in folded stacks");
+}
+
+sub test_errors {
+    my $dir = tempdir(CLEANUP => 1);
+    my $vm = $CLASS->new();
+    ok($vm, "created $CLASS object");
+
+    eval { $vm->stop_profiling('nope') };
+    like($@, qr/Not profiling with name nope/, "stopping an unknown profile dies");
+
+    $vm->start_profiling('twice', { path => "$dir/twice.cpuprofile" });
+    eval { $vm->start_profiling('twice') };
+    like($@, qr/Already profiling with name twice/, "starting a profile twice dies");
+    is($vm->stop_profiling('twice'), "$dir/twice.cpuprofile", "stopped profile");
+
+    eval { $vm->start_profiling('bad', { gonzo => 1 }) };
+    like($@, qr/Unknown option gonzo/, "unknown option dies");
+
+    $vm->start_profiling('nowhere', { path => "$dir/missing/nowhere.cpuprofile" });
+    eval { $vm->stop_profiling('nowhere') };
+    like($@, qr/Could not open/, "unwritable path dies");
+    eval { $vm->stop_profiling('nowhere') };
+    like($@, qr/Not profiling with name nowhere/, "failed profile is gone");
+
+    $vm->start_profiling('reset', { path => "$dir/reset.cpuprofile" });
+    $vm->reset();
+    eval { $vm->stop_profiling('reset') };
+    like($@, qr/Not profiling with name reset/, "reset discards running profiles");
+}
+
+sub test_no_recycle_while_profiling {
+    my $dir = tempdir(CLEANUP => 1);
+    my $vm = $CLASS->new({ recycle_after_evals => 2 });
+    ok($vm, "created $CLASS object with recycle_after_evals");
+
+    $vm->start_profiling('long', { path => "$dir/long.cpuprofile" });
+    $vm->eval('1 + 1') for (1..5);
+    ok(!exists $vm->get_stats()->{recycle}, "not recycled while profiling");
+    is($vm->stop_profiling('long'), "$dir/long.cpuprofile", "profile survived the evals");
+
+    $vm->eval('1 + 1');
+    is($vm->get_stats()->{recycle}{count}, 1, "recycled after the profile was stopped");
+}
+
+sub main {
+    use_ok($CLASS);
+
+    test_profiling();
+    test_errors();
+    test_no_recycle_while_profiling();
+    done_testing;
+    return 0;
+}
+
+exit main();